@@ -0,0 +1,164 @@
+/*
+ * Multi-threaded throughput of ConcurrentSet against a Set protected by a std::mutex.
+ *
+ * Each of 1, 2, 4, ..., max-threads threads runs random operations on one shared set for
+ * a fixed time: a read-mostly mix (90% is_member, 5% insert, 5% erase) and an update-heavy
+ * mix (50% is_member, 25% insert, 25% erase). The values are drawn from [0, range), and the
+ * set initially holds every second value, so that it stays about half full.
+ * Results (operations per second, all threads together) are written to stdout as JSON.
+ *
+ * Usage: ConcurrentBench [--max-threads t] [--range r] [--ms duration]     (build in Release mode)
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "set.h"
+#include "concurrentset.h"
+
+namespace {
+
+/*
+ * Set behind a global lock: the baseline that ConcurrentSet must beat.
+ */
+class MutexSet {
+public:
+    explicit MutexSet(const std::vector<int>& values) : S{values} {
+    }
+    bool is_member(int val) const {
+        std::lock_guard lock{m};
+        return S.is_member(val);
+    }
+    bool insert(int val) {
+        std::lock_guard lock{m};
+        return S.insert(val);
+    }
+    bool erase(int val) {
+        std::lock_guard lock{m};
+        return S.erase(val);
+    }
+
+private:
+    mutable std::mutex m;
+    Set S;
+};
+
+std::atomic<size_t> sink{0};  // results are added here, so that work is not optimized away
+
+struct Mix {
+    const char* name;
+    int member_percent;
+    int insert_percent;  // the rest are erases
+};
+
+struct Result {
+    std::string structure;
+    std::string mix;
+    int threads;
+    double ops_per_second;
+};
+
+/*
+ * Run threads threads on S for duration, and return the total number of operations per second.
+ */
+template <class S>
+double throughput(S& set, const Mix& mix, int threads, int range, std::chrono::milliseconds duration) {
+    std::atomic<bool> go{false};
+    std::atomic<bool> stop{false};
+    std::vector<unsigned long long> done(static_cast<size_t>(threads));
+    std::vector<std::thread> workers;
+
+    for (int t = 0; t < threads; ++t) {
+        workers.emplace_back([&, t] {
+            std::mt19937 rng{static_cast<unsigned>(t + 1)};
+            std::uniform_int_distribution<int> value(0, range - 1);
+            std::uniform_int_distribution<int> percent(0, 99);
+            unsigned long long ops = 0;
+            size_t hits = 0;
+
+            while (!go.load(std::memory_order_acquire)) {
+                std::this_thread::yield();
+            }
+            while (!stop.load(std::memory_order_relaxed)) {
+                int p = percent(rng);
+                int x = value(rng);
+                if (p < mix.member_percent)
+                    hits += set.is_member(x);
+                else if (p < mix.member_percent + mix.insert_percent)
+                    hits += set.insert(x);
+                else
+                    hits += set.erase(x);
+                ++ops;
+            }
+            done[static_cast<size_t>(t)] = ops;
+            sink.fetch_add(hits, std::memory_order_relaxed);
+        });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    go.store(true, std::memory_order_release);
+    std::this_thread::sleep_for(duration);
+    stop.store(true, std::memory_order_relaxed);
+    for (auto& w : workers) w.join();
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    unsigned long long total = 0;
+    for (auto ops : done) total += ops;
+    return static_cast<double>(total) / seconds;
+}
+
+void write_json(std::ostream& os, const std::vector<Result>& results, int range) {
+    os << "{\n  \"range\": " << range << ",\n  \"hardware_threads\": " << std::thread::hardware_concurrency()
+       << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        os << "    {\"structure\": \"" << r.structure << "\", \"mix\": \"" << r.mix << "\", \"threads\": " << r.threads
+           << ", \"ops_per_second\": " << r.ops_per_second << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int max_threads = 64;
+    int range = 1024;
+    int ms = 200;
+    for (int i = 1; i < argc; i += 2) {
+        std::string option{argv[i]};
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value != nullptr && option == "--max-threads") {
+            max_threads = std::atoi(value);
+        } else if (value != nullptr && option == "--range") {
+            range = std::atoi(value);
+        } else if (value != nullptr && option == "--ms") {
+            ms = std::atoi(value);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--max-threads t] [--range r] [--ms duration]\n";
+            return 2;
+        }
+    }
+
+    std::vector<int> initial;
+    for (int x = 0; x < range; x += 2) initial.push_back(x);
+
+    std::vector<Result> results;
+    for (const Mix& mix : {Mix{"90/5/5", 90, 5}, Mix{"50/25/25", 50, 25}}) {
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            ConcurrentSet lock_free{initial};
+            MutexSet locked{initial};
+            auto duration = std::chrono::milliseconds{ms};
+            results.push_back({"ConcurrentSet", mix.name, threads, throughput(lock_free, mix, threads, range, duration)});
+            results.push_back({"mutex Set", mix.name, threads, throughput(locked, mix, threads, range, duration)});
+        }
+    }
+
+    write_json(std::cout, results, range);
+}
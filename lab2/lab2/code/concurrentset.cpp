@@ -0,0 +1,528 @@
+#include "concurrentset.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+
+namespace {
+
+constexpr std::uintptr_t mark_bit = 1;
+
+bool is_marked(std::uintptr_t word) {
+    return (word & mark_bit) != 0;
+}
+
+std::uintptr_t as_word(const void* p) {
+    return reinterpret_cast<std::uintptr_t>(p);
+}
+
+}  // namespace
+
+/*
+ * Node of the list. The lowest bit of next is the mark: a marked Node has been erased,
+ * its next pointer never changes again, and it is about to be unlinked.
+ * inserted and erased are the times of the clock at which the Node was linked and marked
+ * (see stamp_inserted and stamp_erased), or unstamped until a thread stamps them.
+ */
+struct ConcurrentSet::Node {
+    static constexpr std::uint64_t unstamped = ~std::uint64_t{0};
+
+    int value;
+    std::atomic<std::uintptr_t> next;
+    std::atomic<std::uint64_t> inserted;
+    std::atomic<std::uint64_t> erased;
+
+    Node(int value, std::uintptr_t next, std::uint64_t inserted = unstamped, std::uint64_t erased = unstamped)
+        : value{value}, next{next}, inserted{inserted}, erased{erased} {
+    }
+
+    /*
+     * The Node that a next pointer refers to, without the mark.
+     */
+    static Node* from(std::uintptr_t word) {
+        return reinterpret_cast<Node*>(word & ~mark_bit);
+    }
+};
+
+/*
+ * Log of a snapshot: copies of the Nodes unlinked while it runs, linked by their next pointers
+ * (a stack, pushed with a CAS). A Log is reused by later snapshots, never removed.
+ */
+struct ConcurrentSet::Log {
+    std::atomic<bool> in_use{true};
+    std::atomic<bool> running{false};  // whether Nodes must be copied to this Log
+    std::atomic<Node*> entries{nullptr};
+    Log* next = nullptr;
+
+    static void clear(Node* p) {
+        while (p != nullptr) {
+            Node* temp = p;
+            p = Node::from(p->next.load(std::memory_order_relaxed));
+            delete temp;
+        }
+    }
+};
+
+/** Epoch-based reclamation.
+ *
+ * A global epoch counter is shared by all ConcurrentSets. Each thread has a Record, in which it
+ * publishes the epoch it observed when it entered an operation (a Guard), or inactive.
+ * A Node unlinked when the global epoch is e goes to the limbo list of e of its thread: only
+ * threads that entered in epoch e or before might still read it. The global epoch moves from
+ * e to e + 1 only when every active thread is in epoch e, so when the global epoch is e + 2,
+ * every thread has left the operations it started in epoch e or before, and the Nodes unlinked
+ * in e are deleted (by their thread, when it enters epoch e + 2 or later).
+ * The limbo lists are indexed by epoch % 3.
+ */
+class ConcurrentSet::Epoch {
+public:
+    /*
+     * State of a thread. A Record is released when its thread exits and reused by a new thread,
+     * together with the Nodes left in its limbo lists.
+     */
+    struct alignas(64) Record {
+        std::atomic<std::uint64_t> epoch{inactive};  // epoch of the thread, or inactive
+        std::atomic<bool> in_use{true};
+        Record* next = nullptr;
+
+        int depth = 0;                 // number of nested Guards
+        std::uint64_t last_epoch = 0;  // epoch in which the limbo lists were last emptied
+        std::size_t retired = 0;       // Nodes retired since the last attempt to advance
+        std::vector<Node*> limbo[3];   // Nodes unlinked in global epoch e are in limbo[e % 3]
+    };
+
+    /*
+     * The current thread is in an epoch while a Guard exists (Guards can be nested).
+     */
+    class Guard {
+    public:
+        Guard();
+        ~Guard();
+
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+
+        /*
+         * Delete p once no thread can be reading it anymore.
+         * p must have been unlinked from its list.
+         */
+        void retire(Node* p);
+
+    private:
+        Record& record;
+    };
+
+    ~Epoch();
+
+private:
+    static constexpr std::uint64_t inactive = ~std::uint64_t{0};
+
+    // Retired Nodes of a thread after which it tries to advance the global epoch
+    static constexpr std::size_t advance_threshold = 64;
+
+    std::atomic<std::uint64_t> global{0};
+    std::atomic<Record*> records{nullptr};  // all Records, never removed
+
+    static Epoch& domain();
+    static Record& local();
+
+    Record& acquire();
+    void try_advance();
+};
+
+/*
+ * Created on first use by a Guard: it is destroyed after the thread_local Records are released.
+ */
+ConcurrentSet::Epoch& ConcurrentSet::Epoch::domain() {
+    static Epoch the_domain;
+    return the_domain;
+}
+
+ConcurrentSet::Epoch::Record& ConcurrentSet::Epoch::local() {
+    struct Owner {
+        Record& record = domain().acquire();
+        ~Owner() {
+            record.in_use.store(false, std::memory_order_release);
+        }
+    };
+    thread_local Owner owner;
+    return owner.record;
+}
+
+/*
+ * Reuse a released Record, or push a new one on the list.
+ */
+ConcurrentSet::Epoch::Record& ConcurrentSet::Epoch::acquire() {
+    for (Record* r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+        bool expected = false;
+        if (!r->in_use.load(std::memory_order_relaxed) && r->in_use.compare_exchange_strong(expected, true)) {
+            return *r;
+        }
+    }
+    Record* r = new Record{};
+    r->next = records.load(std::memory_order_relaxed);
+    while (!records.compare_exchange_weak(r->next, r)) {
+    }
+    return *r;
+}
+
+/*
+ * The epoch moves on only if every active thread has observed the current one.
+ */
+void ConcurrentSet::Epoch::try_advance() {
+    std::uint64_t e = global.load();
+    for (Record* r = records.load(std::memory_order_acquire); r != nullptr; r = r->next) {
+        std::uint64_t observed = r->epoch.load();
+        if (observed != inactive && observed != e) return;
+    }
+    global.compare_exchange_strong(e, e + 1);
+}
+
+/*
+ * At exit no other thread uses the ConcurrentSets anymore: all limbo lists are deleted.
+ */
+ConcurrentSet::Epoch::~Epoch() {
+    Record* r = records.load();
+    while (r != nullptr) {
+        for (auto& list : r->limbo) {
+            for (Node* p : list) delete p;
+        }
+        Record* temp = r;
+        r = r->next;
+        delete temp;
+    }
+}
+
+/*
+ * The epoch is published, then the global epoch is read again: if it moved on meanwhile (while
+ * other threads could not see this thread yet), the new epoch is published instead.
+ * On entering a new epoch, the Nodes unlinked two epochs ago, or before, are deleted.
+ */
+ConcurrentSet::Epoch::Guard::Guard() : record{local()} {
+    if (record.depth++ > 0) return;
+
+    std::uint64_t e = domain().global.load();
+    while (true) {
+        record.epoch.store(e);
+        std::uint64_t now = domain().global.load();
+        if (now == e) break;
+        e = now;
+    }
+    if (e != record.last_epoch) {
+        std::vector<Node*>& old = record.limbo[(e + 1) % 3];
+        for (Node* p : old) delete p;
+        old.clear();
+        record.last_epoch = e;
+    }
+}
+
+ConcurrentSet::Epoch::Guard::~Guard() {
+    if (--record.depth == 0) record.epoch.store(inactive, std::memory_order_release);
+}
+
+void ConcurrentSet::Epoch::Guard::retire(Node* p) {
+    record.limbo[domain().global.load() % 3].push_back(p);
+    if (++record.retired >= advance_threshold) {
+        record.retired = 0;
+        domain().try_advance();
+    }
+}
+
+/*****************************************************
+ * Implementation of the member functions             *
+ ******************************************************/
+
+ConcurrentSet::ConcurrentSet()
+    : head{new Node{0, 0}}, counter{0}, clock{0}, logs{nullptr} {
+}
+
+/*
+ * The vector is checked to be sorted increasingly, with unique values, in one pass;
+ * otherwise the list is built from a sorted copy without repetitions.
+ */
+ConcurrentSet::ConcurrentSet(const std::vector<int>& list_of_values) : ConcurrentSet() {
+    if (std::adjacent_find(list_of_values.begin(), list_of_values.end(), std::greater_equal<int>{}) ==
+        list_of_values.end()) {
+        append_all(list_of_values);
+        return;
+    }
+    std::vector<int> values{list_of_values};
+    std::sort(values.begin(), values.end());
+    values.erase(std::unique(values.begin(), values.end()), values.end());
+    append_all(values);
+}
+
+ConcurrentSet::ConcurrentSet(const Set& S) : ConcurrentSet() {
+    append_all(std::vector<int>(S.begin(), S.end()));
+}
+
+/*
+ * The Nodes still linked, marked or not, are deleted here, and so are the Logs.
+ */
+ConcurrentSet::~ConcurrentSet() {
+    Node* p = head;
+    while (p != nullptr) {
+        Node* temp = p;
+        p = Node::from(p->next.load(std::memory_order_relaxed));
+        delete temp;
+    }
+    Log* r = logs.load();
+    while (r != nullptr) {
+        Log::clear(r->entries.load());
+        Log* temp = r;
+        r = r->next;
+        delete temp;
+    }
+}
+
+/*
+ * A single walk, which never restarts: marked Nodes are passed over,
+ * since their next pointers still lead to the rest of the list.
+ * val belongs to the set if its Node is found and not marked. The Node found is stamped first,
+ * so that the insert (or erase) seen here is ordered before the answer, also for snapshots.
+ */
+bool ConcurrentSet::is_member(int val) const {
+    Epoch::Guard guard;
+
+    Node* curr = Node::from(head->next.load(std::memory_order_acquire));
+    while (curr != nullptr && curr->value < val) {
+        curr = Node::from(curr->next.load(std::memory_order_acquire));
+    }
+    if (curr == nullptr || curr->value != val) return false;
+
+    stamp_inserted(curr);
+    if (is_marked(curr->next.load())) {
+        stamp_erased(curr);
+        return false;
+    }
+    return true;
+}
+
+/*
+ * The new Node is linked before the first Node not smaller than val, by a CAS of the next pointer
+ * of its predecessor: the CAS fails if the predecessor was marked or another Node was linked
+ * after it in the meantime, and then the window is searched again.
+ */
+bool ConcurrentSet::insert(int val) {
+    Epoch::Guard guard;
+    Node* new_node = nullptr;
+
+    while (true) {
+        Window w = find(val);
+        if (w.curr != nullptr && w.curr->value == val) {
+            stamp_inserted(w.curr);
+            if (is_marked(w.curr->next.load())) continue;  // erased meanwhile, find unlinks it
+            delete new_node;
+            return false;  // already present
+        }
+        if (new_node == nullptr) new_node = new Node{val, 0};
+        new_node->next.store(as_word(w.curr), std::memory_order_relaxed);
+
+        std::uintptr_t expected = as_word(w.curr);
+        if (w.prev->next.compare_exchange_strong(expected, as_word(new_node), std::memory_order_acq_rel)) {
+            stamp_inserted(new_node);
+            counter.fetch_add(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+}
+
+/*
+ * The Node of val is erased when the CAS marking its next pointer succeeds.
+ * Then it is stamped and reported, and one attempt is made to unlink it; if that fails, find unlinks it.
+ */
+bool ConcurrentSet::erase(int val) {
+    Epoch::Guard guard;
+
+    while (true) {
+        Window w = find(val);
+        if (w.curr == nullptr || w.curr->value != val) return false;  // not present
+
+        std::uintptr_t next = w.curr->next.load(std::memory_order_acquire);
+        if (is_marked(next)) continue;  // erased by another thread, find unlinks it
+
+        stamp_inserted(w.curr);  // the insert is ordered before the erase
+        if (!w.curr->next.compare_exchange_strong(next, next | mark_bit, std::memory_order_acq_rel)) continue;
+
+        counter.fetch_sub(1, std::memory_order_relaxed);
+        report_erased(w.curr);
+        std::uintptr_t expected = as_word(w.curr);
+        if (w.prev->next.compare_exchange_strong(expected, next)) {
+            guard.retire(w.curr);
+        } else {
+            find(val);
+        }
+        return true;
+    }
+}
+
+/*
+ * The snapshot is taken at time now of the clock: the values are those of the Nodes inserted
+ * at or before now, and not erased at or before now. Any Node with a later stamp, or stamped
+ * by the snapshot itself, was inserted or erased after the snapshot.
+ * Such a Node is found by the walk, unless it was unlinked before the walk reached it: its
+ * erasure is then stamped after now, so it was copied to the Log of the snapshot, which runs
+ * from before now (see report_erased). A Node may be both found and copied.
+ */
+std::vector<int> ConcurrentSet::snapshot() const {
+    Epoch::Guard guard;
+    Log& log = acquire_log();
+    Log::clear(log.entries.exchange(nullptr));  // copies pushed after the previous snapshot ended
+    log.running.store(true);
+    const std::uint64_t now = clock.fetch_add(1);
+
+    auto present = [now](const Node* p) {
+        return p->inserted.load() <= now && p->erased.load() > now;
+    };
+
+    std::vector<int> values;
+    values.reserve(cardinality());
+    for (Node* p = Node::from(head->next.load(std::memory_order_acquire)); p != nullptr;) {
+        stamp_inserted(p);
+        std::uintptr_t next = p->next.load();
+        if (is_marked(next)) stamp_erased(p);
+        if (present(p)) values.push_back(p->value);
+        p = Node::from(next);
+    }
+
+    Node* copies = log.entries.exchange(nullptr);
+    log.running.store(false);
+    log.in_use.store(false, std::memory_order_release);
+
+    if (copies != nullptr) {
+        for (Node* q = copies; q != nullptr; q = Node::from(q->next.load(std::memory_order_relaxed))) {
+            if (present(q)) values.push_back(q->value);
+        }
+        Log::clear(copies);
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+    return values;
+}
+
+std::ostream& operator<<(std::ostream& os, const ConcurrentSet& S) {
+    std::vector<int> values = S.snapshot();
+    if (values.empty()) return os << "Set is empty!";
+
+    os << "{ ";
+    for (int val : values) {
+        os << val << " ";
+    }
+    return os << "}";
+}
+
+std::vector<int> operator+(const ConcurrentSet& S1, const ConcurrentSet& S2) {
+    std::vector<int> a = S1.snapshot(), b = S2.snapshot(), result;
+    result.reserve(a.size() + b.size());
+    std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
+
+std::vector<int> operator*(const ConcurrentSet& S1, const ConcurrentSet& S2) {
+    std::vector<int> a = S1.snapshot(), b = S2.snapshot(), result;
+    result.reserve(std::min(a.size(), b.size()));
+    std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
+
+std::vector<int> operator-(const ConcurrentSet& S1, const ConcurrentSet& S2) {
+    std::vector<int> a = S1.snapshot(), b = S2.snapshot(), result;
+    result.reserve(a.size());
+    std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+    return result;
+}
+
+/*****************************************************
+ * Private Member Functions -- Implementation         *
+ ******************************************************/
+
+/*
+ * Walk the list from the head. A marked Node is unlinked from its predecessor with a CAS, and
+ * retired. If that CAS fails, the predecessor was marked or changed, and the walk restarts.
+ */
+ConcurrentSet::Window ConcurrentSet::find(int val) {
+    Epoch::Guard guard;  // nested in the Guard of the caller
+
+    while (true) {
+        Node* prev = head;
+        Node* curr = Node::from(prev->next.load(std::memory_order_acquire));
+        bool restart = false;
+
+        while (curr != nullptr) {
+            std::uintptr_t next = curr->next.load(std::memory_order_acquire);
+            if (is_marked(next)) {
+                report_erased(curr);
+                std::uintptr_t expected = as_word(curr);
+                if (!prev->next.compare_exchange_strong(expected, next & ~mark_bit)) {
+                    restart = true;
+                    break;
+                }
+                guard.retire(curr);
+                curr = Node::from(next);
+                continue;
+            }
+            if (curr->value >= val) break;
+            prev = curr;
+            curr = Node::from(next);
+        }
+        if (!restart) return Window{prev, curr};
+    }
+}
+
+/*
+ * The clock is read after p was linked (or marked): the stamp is a time between the CAS of the
+ * update and the first thread that sees the Node stamped, so the update can be ordered there.
+ * Several threads may try to stamp p; the first CAS wins.
+ */
+void ConcurrentSet::stamp_inserted(Node* p) const {
+    if (p->inserted.load() != Node::unstamped) return;
+    std::uint64_t expected = Node::unstamped;
+    p->inserted.compare_exchange_strong(expected, clock.load());
+}
+
+void ConcurrentSet::stamp_erased(Node* p) const {
+    if (p->erased.load() != Node::unstamped) return;
+    stamp_inserted(p);  // so that inserted <= erased
+    std::uint64_t expected = Node::unstamped;
+    p->erased.compare_exchange_strong(expected, clock.load());
+}
+
+/*
+ * A snapshot sets running before it advances the clock, so a Node whose erasure is stamped
+ * after the snapshot's time sees running here, and is copied before it is unlinked.
+ * A copy pushed to a Log once its snapshot has read it is dropped by the next snapshot.
+ */
+void ConcurrentSet::report_erased(Node* p) {
+    stamp_erased(p);
+    for (Log* r = logs.load(); r != nullptr; r = r->next) {
+        if (!r->running.load()) continue;
+        Node* copy = new Node{p->value, 0, p->inserted.load(), p->erased.load()};
+        Node* top = r->entries.load();
+        do {
+            copy->next.store(as_word(top), std::memory_order_relaxed);
+        } while (!r->entries.compare_exchange_weak(top, copy));
+    }
+}
+
+auto ConcurrentSet::acquire_log() const -> Log& {
+    for (Log* r = logs.load(); r != nullptr; r = r->next) {
+        bool expected = false;
+        if (!r->in_use.load(std::memory_order_relaxed) && r->in_use.compare_exchange_strong(expected, true)) {
+            return *r;
+        }
+    }
+    Log* r = new Log{};
+    r->next = logs.load();
+    while (!logs.compare_exchange_weak(r->next, r)) {
+    }
+    return *r;
+}
+
+void ConcurrentSet::append_all(const std::vector<int>& values) {
+    Node* last = head;
+    for (int val : values) {
+        Node* new_node = new Node{val, 0, 0};  // present before any snapshot
+        last->next.store(as_word(new_node), std::memory_order_relaxed);
+        last = new_node;
+    }
+    counter.store(values.size(), std::memory_order_relaxed);
+}
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <atomic>
+#include <cstdint>
+#include <cstddef>
+
+#include "set.h"
+
+/** Class to represent a Set of ints shared by several threads.
+ *
+ *  ConcurrentSet is a sorted singly linked list, as in Set, but all its operations can be
+ *  called concurrently from any number of threads, without a lock (Harris-Michael list):
+ *  - is_member is wait-free: it walks the list once (its only writes are the stamps below).
+ *  - insert and erase are lock-free: a Node is linked with one compare-and-swap (CAS) of
+ *    the next pointer of its predecessor. A Node is erased by first marking its own next
+ *    pointer (the lowest bit), so that no Node can be linked after it anymore, and then
+ *    unlinking it. Any thread that finds a marked Node unlinks it.
+ *  - A Node unlinked by one thread may still be read by others. It is deleted only when all
+ *    threads have left the operations that were running when it was unlinked
+ *    (epoch-based reclamation, see concurrentset.cpp).
+ *  - snapshot returns the values of the ConcurrentSet at one instant (linearizable), and is
+ *    lock-free too: it never waits for an update, and updates never wait for it.
+ *    Each Node is stamped with the times, read on a clock of the ConcurrentSet, at which it was
+ *    inserted and erased; any thread that meets a Node not stamped yet stamps it. A snapshot
+ *    advances the clock, walks the list, and keeps the Nodes inserted before and not erased
+ *    before its own time. The Nodes unlinked during the walk are copied, before they are
+ *    unlinked, to the log of every running snapshot (see concurrentset.cpp).
+ *    operator<< and the algebra operators work on snapshots. They return sorted vectors, not Sets:
+ *    Sets share a NodePool and a Node counter that are not thread-safe (see set.h).
+ *
+ *  Sets should not contain repetitions, i.e.
+ *  two ints with the same value cannot belong to a ConcurrentSet.
+ *  A ConcurrentSet cannot be copied or moved, since other threads may be using it;
+ *  its snapshot can. It must not be destroyed while other threads are still using it.
+ */
+class ConcurrentSet {
+public:
+    /*
+     * Default constructor: create an empty ConcurrentSet.
+     */
+    ConcurrentSet();
+
+    /*
+     * Constructor to create a ConcurrentSet from a vector of ints.
+     * \param list_of_values is usually an increasingly sorted vector of unique ints,
+     * otherwise a sorted copy without repetitions is made first.
+     */
+    explicit ConcurrentSet(const std::vector<int>& list_of_values);
+
+    /*
+     * Constructor to create a ConcurrentSet with the values of Set S.
+     */
+    explicit ConcurrentSet(const Set& S);
+
+    ConcurrentSet(const ConcurrentSet&) = delete;
+    ConcurrentSet& operator=(const ConcurrentSet&) = delete;
+
+    /*
+     * Destructor: deallocate the Nodes of the list.
+     * Nodes already unlinked are deleted by the epoch-based reclamation.
+     */
+    ~ConcurrentSet();
+
+    /*
+     * Test whether val belongs to the ConcurrentSet (wait-free).
+     * Return true if val belongs to the set, otherwise false.
+     */
+    bool is_member(int val) const;
+
+    /*
+     * Insert val in the ConcurrentSet, if it does not belong to it yet (lock-free).
+     * Return true if val was inserted, otherwise false.
+     */
+    bool insert(int val);
+
+    /*
+     * Remove val from the ConcurrentSet, if it belongs to it (lock-free).
+     * Return true if val was removed, otherwise false.
+     */
+    bool erase(int val);
+
+    /*
+     * Count the number of values stored in the ConcurrentSet.
+     * While other threads insert and erase values, the count may lag behind the list;
+     * it is exact when no insert or erase is running.
+     */
+    size_t cardinality() const {
+        return counter.load(std::memory_order_relaxed);
+    }
+
+    /*
+     * Test whether the ConcurrentSet is empty, with the same caveat as cardinality.
+     */
+    bool is_empty() const {
+        return cardinality() == 0;
+    }
+
+    /*
+     * Return the values of the ConcurrentSet at one instant between the call and the return,
+     * in increasing order. The list is read once, whatever the inserts and erases running meanwhile.
+     */
+    std::vector<int> snapshot() const;
+
+    /* *******************************************
+     * Overloaded operators: non-member functions *
+     * ******************************************* */
+
+    /*
+     * Overloaded operator<<: write a snapshot of S, in the format of Set.
+     */
+    friend std::ostream& operator<<(std::ostream& os, const ConcurrentSet& S);
+
+    /*
+     * Union, intersection, and difference of the snapshots of S1 and S2, as sorted vectors.
+     * Each snapshot is linearizable, but the two are not taken at the same instant.
+     */
+    friend std::vector<int> operator+(const ConcurrentSet& S1, const ConcurrentSet& S2);
+    friend std::vector<int> operator*(const ConcurrentSet& S1, const ConcurrentSet& S2);
+    friend std::vector<int> operator-(const ConcurrentSet& S1, const ConcurrentSet& S2);
+
+private:
+    // Node of the list (defined in concurrentset.cpp)
+    struct Node;
+
+    // Epoch-based reclamation of the unlinked Nodes (defined in concurrentset.cpp)
+    class Epoch;
+
+    // Position of val in the list: curr is the first Node not smaller than val (or nullptr)
+    struct Window {
+        Node* prev;
+        Node* curr;
+    };
+
+    // Log of the Nodes unlinked while a snapshot runs (defined in concurrentset.cpp)
+    struct Log;
+
+    Node* head;                      // Dummy header Node, its value is not used
+    std::atomic<size_t> counter;     // Number of values in the ConcurrentSet
+
+    // Clock read by the stamps of the Nodes, advanced only by snapshot.
+    // On its own cache line, since every update reads it.
+    alignas(64) mutable std::atomic<std::uint64_t> clock;
+    mutable std::atomic<Log*> logs;  // Logs of all snapshots, running or not, never removed
+
+    /* **************************
+     * Private Member Functions *
+     * ************************** */
+
+    /*
+     * Find the window of val, unlinking the marked Nodes met on the way.
+     * Must be called while the thread is in an epoch.
+     */
+    Window find(int val);
+
+    /*
+     * Stamp the insertion of p, or the erasure of the marked Node p, if no thread has done it yet.
+     */
+    void stamp_inserted(Node* p) const;
+    void stamp_erased(Node* p) const;
+
+    /*
+     * Stamp the erasure of the marked Node p, and copy p to the log of every running snapshot.
+     * Called before p is unlinked.
+     */
+    void report_erased(Node* p);
+
+    /*
+     * Reuse a Log that no snapshot uses, or add a new one.
+     */
+    Log& acquire_log() const;
+
+    /*
+     * Append the values of a sorted vector of unique ints (while the list is not shared yet).
+     */
+    void append_all(const std::vector<int>& values);
+};
@@ -0,0 +1,148 @@
+/*
+ * Speed of the Set files (see setfile.h) against the text format of operator<<.
+ *
+ * A Set of n values, drawn from [0, 4n), is written in text (operator<<), raw and delta format.
+ * Each file is then read back: the text one is parsed with operator>> into a vector, and the binary
+ * ones are mapped and scanned in place (raw only), decoded into a vector, and converted to a Set.
+ * Results (best of a few runs, in MB of file per second and values per second) are written to stdout
+ * as JSON. The files are in the page cache when read: this is the decoding speed, that a disk
+ * must match for loading to be bound by the disk.
+ *
+ * Usage: FileBench [--size n] [--dir directory]     (build in Release mode)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "set.h"
+#include "setfile.h"
+
+namespace {
+
+constexpr int repetitions = 3;
+
+size_t sink = 0;  // results are added here, so that work is not optimized away
+
+struct Result {
+    std::string format;
+    std::string operation;
+    double file_mb;
+    double seconds;
+};
+
+/*
+ * Best time of f over the repetitions, in seconds.
+ */
+template <class F>
+double best_seconds(F f) {
+    double best = 1e300;
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        sink += f();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+/*
+ * Parse the text of operator<< ("{ 1 3 5 }") into a vector.
+ */
+size_t parse_text(const std::string& path) {
+    std::ifstream is{path};
+    std::string brace;
+    is >> brace;
+    std::vector<int> values;
+    int val;
+    while (is >> val) values.push_back(val);
+    return values.size();
+}
+
+void write_json(std::ostream& os, const std::vector<Result>& results, size_t n) {
+    os << "{\n  \"size\": " << n << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        os << "    {\"format\": \"" << r.format << "\", \"operation\": \"" << r.operation << "\", \"file_mb\": " << r.file_mb
+           << ", \"mb_per_second\": " << r.file_mb / r.seconds
+           << ", \"values_per_second\": " << static_cast<double>(n) / r.seconds << "}"
+           << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int n = 10000000;
+    std::string dir = std::filesystem::temp_directory_path().string();
+    for (int i = 1; i < argc; i += 2) {
+        std::string option{argv[i]};
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value != nullptr && option == "--size") {
+            n = std::atoi(value);
+        } else if (value != nullptr && option == "--dir") {
+            dir = value;
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--size n] [--dir directory]\n";
+            return 2;
+        }
+    }
+
+    std::vector<int> values;
+    {
+        std::mt19937 rng{1};
+        std::uniform_int_distribution<int> value(0, 4 * n - 1);
+        for (int i = 0; i < n; ++i) values.push_back(value(rng));
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+
+    std::vector<Result> results;
+    auto megabytes = [](const std::string& path) {
+        return static_cast<double>(std::filesystem::file_size(path)) / 1e6;
+    };
+
+    const std::string text_path = dir + "/filebench.txt";
+    {
+        Set S{values};
+        std::ofstream os{text_path};
+        os << S;
+    }
+    results.push_back({"text", "parse", megabytes(text_path), best_seconds([&] { return parse_text(text_path); })});
+    std::remove(text_path.c_str());
+
+    for (auto encoding : {set_file::Encoding::raw, set_file::Encoding::delta}) {
+        const bool raw = encoding == set_file::Encoding::raw;
+        const std::string format = raw ? "raw" : "delta";
+        const std::string path = dir + "/filebench." + format;
+
+        double t = best_seconds([&] {
+            set_file::write(path, values, encoding);
+            return values.size();
+        });
+        const double mb = megabytes(path);
+        results.push_back({format, "write", mb, t});
+
+        if (raw) {
+            results.push_back({format, "map and scan", mb, best_seconds([&] {
+                                   set_file::MappedSet M{path};
+                                   long long sum = 0;
+                                   for (int val : M.values()) sum += val;
+                                   return static_cast<size_t>(sum);
+                               })});
+        }
+        results.push_back({format, "to_vector", mb, best_seconds([&] { return set_file::MappedSet{path}.to_vector().size(); })});
+        results.push_back({format, "to_set", mb, best_seconds([&] { return set_file::read(path).cardinality(); })});
+        std::remove(path.c_str());
+    }
+
+    write_json(std::cout, results, values.size());
+}
@@ -0,0 +1,328 @@
+#include "flatset.h"
+#include "flatsimd.h"
+#include "threadpool.h"
+#include <algorithm>
+#include <functional>
+#include <span>
+#include <utility>
+
+namespace {
+
+/*
+ * Galloping (exponential) search: return the first position in [first, last)
+ * whose value is not less than val.
+ * Probes first[1], first[3], first[7], ... and then binary searches the last gap,
+ * so the cost is O(log d) where d is the distance from first to the result.
+ */
+const int* gallop(const int* first, const int* last, int val) {
+    if (first == last || !(*first < val)) return first;
+
+    size_t n = static_cast<size_t>(last - first);
+    size_t bound = 1;
+    while (bound < n && first[bound] < val) {
+        bound *= 2;
+    }
+    // first[bound / 2] < val and (bound >= n or first[bound] >= val)
+    return std::lower_bound(first + bound / 2 + 1, first + std::min(bound, n), val);
+}
+
+/*
+ * Move [first, last) to out, which is never after first (the ranges may overlap).
+ * Return the end of the moved values.
+ */
+int* shift_left(const int* first, const int* last, int* out) {
+    if (out == first) return out + (last - first);
+    return std::copy(first, last, out);
+}
+
+/*
+ * Merge path: return the split (i, j), i + j == d, of a and b such that a[0, i) and b[0, j) are
+ * the first d values of their merge, where a value of a comes before an equal value of b.
+ * The values of the merge before position d are <= the values after it.
+ * If a[i - 1] == b[j], b[j] is taken before the split as well, so that the two copies of a value
+ * are never separated (the split is then the one for d + 1).
+ * Binary search on i: O(log min(|a|, |b|)) time.
+ */
+std::pair<size_t, size_t> co_rank(std::span<const int> a, std::span<const int> b, size_t d) {
+    size_t lo = d > b.size() ? d - b.size() : 0;
+    size_t hi = std::min(d, a.size());
+    while (lo < hi) {
+        size_t i = lo + (hi - lo) / 2;
+        // i < hi <= |a|, and 1 <= d - i <= |b|
+        if (a[i] <= b[d - i - 1])
+            lo = i + 1;  // a[i] comes before b[d - i - 1], so it is in the first d values
+        else
+            hi = i;
+    }
+    size_t i = lo;
+    size_t j = d - lo;
+    if (i > 0 && j < b.size() && a[i - 1] == b[j]) ++j;
+    return {i, j};
+}
+
+}  // namespace
+
+/*****************************************************
+ * Implementation of the member functions             *
+ ******************************************************/
+
+/*
+ * One pass checks that the values are already increasingly sorted without repetitions.
+ */
+FlatSet::FlatSet(const std::vector<int>& list_of_values) : values{list_of_values} {
+    if (std::adjacent_find(values.begin(), values.end(), std::greater_equal<int>{}) != values.end()) {
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+    }
+}
+
+/*
+ * Binary search, since the values are sorted.
+ */
+bool FlatSet::is_member(int val) const {
+    return std::binary_search(values.begin(), values.end(), val);
+}
+
+std::vector<bool> FlatSet::are_members(std::span<const int> sorted_queries) const {
+    std::vector<unsigned char> found(sorted_queries.size());
+    flat_simd::kernels().are_members(values.data(), values.size(), sorted_queries.data(), sorted_queries.size(),
+                                     found.data());
+    return std::vector<bool>(found.begin(), found.end());
+}
+
+/*
+ * Single simultaneous pass through both vectors.
+ * this_subset_S becomes false when a value of *this is missing in S, and
+ * S_subset_this becomes false when a value of S is missing in *this.
+ */
+std::partial_ordering FlatSet::operator<=>(const FlatSet& S) const {
+    bool this_subset_S = values.size() <= S.values.size();
+    bool S_subset_this = S.values.size() <= values.size();
+
+    const int* p1 = values.data();
+    const int* end1 = p1 + values.size();
+    const int* p2 = S.values.data();
+    const int* end2 = p2 + S.values.size();
+
+    while ((this_subset_S || S_subset_this) && p1 != end1 && p2 != end2) {
+        if (*p1 < *p2) {
+            this_subset_S = false;
+            ++p1;
+        } else if (*p2 < *p1) {
+            S_subset_this = false;
+            ++p2;
+        } else {
+            ++p1;
+            ++p2;
+        }
+    }
+    if (p1 != end1) this_subset_S = false;
+    if (p2 != end2) S_subset_this = false;
+
+    if (this_subset_S && S_subset_this)
+        return std::partial_ordering::equivalent;
+    else if (this_subset_S)
+        return std::partial_ordering::less;
+    else if (S_subset_this)
+        return std::partial_ordering::greater;
+    else
+        return std::partial_ordering::unordered;
+}
+
+/*
+ * The union is merged into a new buffer, which then replaces values, by the best
+ * kernel for the CPU (see flatsimd.h). With skewed sizes, each value of the smaller set gallops to its position in the
+ * larger one and the run of values skipped over is copied as a block.
+ */
+FlatSet& FlatSet::operator+=(const FlatSet& S) {
+    if (this == &S || S.values.empty()) return *this;
+
+    std::vector<int> result;
+    result.reserve(values.size() + S.values.size());
+
+    if (use_gallop(values.size(), S.values.size())) {
+        const std::vector<int>& small = (values.size() < S.values.size()) ? values : S.values;
+        const std::vector<int>& large = (values.size() < S.values.size()) ? S.values : values;
+
+        const int* pl = large.data();
+        const int* end_l = pl + large.size();
+
+        for (int val : small) {
+            const int* q = gallop(pl, end_l, val);
+            result.insert(result.end(), pl, q);
+            pl = (q != end_l && *q == val) ? q + 1 : q;
+            result.push_back(val);
+        }
+        result.insert(result.end(), pl, end_l);
+    } else {
+        result.resize(values.size() + S.values.size());
+        result.resize(flat_simd::kernels().unite(values.data(), values.size(), S.values.data(), S.values.size(),
+                                                 result.data()));
+    }
+    values.swap(result);
+    return *this;
+}
+
+/*
+ * The intersection is compacted in place: values of *this that also belong to S
+ * are moved to the front of the vector (by a kernel of flatsimd.h, unless galloping).
+ */
+FlatSet& FlatSet::operator*=(const FlatSet& S) {
+    if (this == &S) return *this;
+
+    int* out = values.data();
+    const int* p1 = values.data();
+    const int* end1 = p1 + values.size();
+    const int* p2 = S.values.data();
+    const int* end2 = p2 + S.values.size();
+
+    if (use_gallop(values.size(), S.values.size())) {
+        if (values.size() < S.values.size()) {
+            // Each value of *this gallops in S
+            for (; p1 != end1 && p2 != end2; ++p1) {
+                p2 = gallop(p2, end2, *p1);
+                if (p2 != end2 && *p2 == *p1) *out++ = *p1;
+            }
+        } else {
+            // Each value of S gallops in *this
+            for (; p2 != end2 && p1 != end1; ++p2) {
+                p1 = gallop(p1, end1, *p2);
+                if (p1 != end1 && *p1 == *p2) *out++ = *p1++;
+            }
+        }
+        values.resize(out - values.data());
+        return *this;
+    }
+
+    values.resize(flat_simd::kernels().intersect(values.data(), values.size(), S.values.data(), S.values.size(),
+                                                 values.data()));
+    return *this;
+}
+
+/*
+ * The difference is compacted in place: values of *this that do not belong to S
+ * are moved to the front of the vector (by a kernel of flatsimd.h, unless galloping).
+ */
+FlatSet& FlatSet::operator-=(const FlatSet& S) {
+    if (this == &S) {
+        make_empty();
+        return *this;
+    }
+
+    int* out = values.data();
+    const int* p1 = values.data();
+    const int* end1 = p1 + values.size();
+    const int* p2 = S.values.data();
+    const int* end2 = p2 + S.values.size();
+
+    if (use_gallop(values.size(), S.values.size())) {
+        if (values.size() < S.values.size()) {
+            // Each value of *this gallops in S
+            for (; p1 != end1 && p2 != end2; ++p1) {
+                p2 = gallop(p2, end2, *p1);
+                if (p2 == end2 || *p2 != *p1) *out++ = *p1;
+            }
+        } else {
+            // Each value of S gallops in *this, the runs in between are kept
+            for (; p2 != end2 && p1 != end1; ++p2) {
+                const int* q = gallop(p1, end1, *p2);
+                out = shift_left(p1, q, out);
+                p1 = (q != end1 && *q == *p2) ? q + 1 : q;
+            }
+        }
+        out = shift_left(p1, end1, out);
+        values.resize(out - values.data());
+        return *this;
+    }
+
+    values.resize(flat_simd::kernels().difference(values.data(), values.size(), S.values.data(), S.values.size(),
+                                                  values.data()));
+    return *this;
+}
+
+FlatSet& FlatSet::parallel_union(const FlatSet& S, ThreadPool& pool) {
+    if (!use_parallel(S)) return *this += S;
+
+    merge_in_slices(S, pool, flat_simd::kernels().unite);
+    return *this;
+}
+
+FlatSet& FlatSet::parallel_union(const FlatSet& S) {
+    return parallel_union(S, ThreadPool::shared());
+}
+
+FlatSet& FlatSet::parallel_intersection(const FlatSet& S, ThreadPool& pool) {
+    if (!use_parallel(S)) return *this *= S;
+
+    merge_in_slices(S, pool, flat_simd::kernels().intersect);
+    return *this;
+}
+
+FlatSet& FlatSet::parallel_intersection(const FlatSet& S) {
+    return parallel_intersection(S, ThreadPool::shared());
+}
+
+FlatSet& FlatSet::parallel_difference(const FlatSet& S, ThreadPool& pool) {
+    if (!use_parallel(S)) return *this -= S;
+
+    merge_in_slices(S, pool, flat_simd::kernels().difference);
+    return *this;
+}
+
+FlatSet& FlatSet::parallel_difference(const FlatSet& S) {
+    return parallel_difference(S, ThreadPool::shared());
+}
+
+/*****************************************************
+ * Private Member Functions -- Implementation         *
+ ******************************************************/
+
+/*
+ * The split points are found by the caller (p binary searches), then each thread merges its slices
+ * into its own buffer. Since equal values are never split (see co_rank), the slices of the result
+ * are disjoint and increasing: once their sizes are known, each thread copies its buffer to
+ * its offset in the result, without any lock.
+ */
+template <class Merge>
+void FlatSet::merge_in_slices(const FlatSet& S, ThreadPool& pool, Merge merge) {
+    std::span<const int> a{values};
+    std::span<const int> b{S.values};
+    const size_t slices = pool.size();
+    const size_t total = a.size() + b.size();
+
+    std::vector<std::pair<size_t, size_t>> splits(slices + 1);
+    splits[slices] = {a.size(), b.size()};
+    for (size_t t = 1; t < slices; ++t) {
+        splits[t] = co_rank(a, b, total * t / slices);
+    }
+
+    std::vector<std::vector<int>> parts(slices);
+    pool.parallel_for(slices, [&](size_t t) {
+        auto [i0, j0] = splits[t];
+        auto [i1, j1] = splits[t + 1];
+        parts[t].resize((i1 - i0) + (j1 - j0));
+        parts[t].resize(merge(a.data() + i0, i1 - i0, b.data() + j0, j1 - j0, parts[t].data()));
+    });
+
+    std::vector<size_t> offsets(slices + 1, 0);
+    for (size_t t = 0; t < slices; ++t) {
+        offsets[t + 1] = offsets[t] + parts[t].size();
+    }
+    std::vector<int> result(offsets[slices]);
+    pool.parallel_for(slices, [&](size_t t) {
+        std::copy(parts[t].begin(), parts[t].end(), result.begin() + static_cast<std::ptrdiff_t>(offsets[t]));
+    });
+    values.swap(result);
+}
+
+void FlatSet::write_to_stream(std::ostream& os) const {
+    if (values.empty()) {
+        os << "Set is empty!";
+    } else {
+        os << "{ ";
+        for (int val : values) {
+            os << val << " ";
+        }
+        os << "}";
+    }
+}
@@ -0,0 +1,207 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <span>
+#include <compare>  // C++20 three-way comparison operator
+
+class ThreadPool;
+
+/** Class to represent a Set of ints stored contiguously.
+ *
+ *  FlatSet has the same public interface as Set, but
+ *  it is implemented as an increasingly sorted std::vector<int>.
+ *  Sets should not contain repetitions, i.e.
+ *  two ints with the same value cannot belong to a FlatSet.
+ *
+ *  Each value takes sizeof(int) bytes (instead of a Set::Node with two pointers)
+ *  and all traversals run over contiguous memory.
+ *  is_member is O(log n), all other operations are linear in the worst case.
+ *  When one operand of +=, *=, -= is much smaller than the other (m << n), the
+ *  larger one is searched with galloping (exponential) search, instead of being
+ *  stepped through value by value, so that only O(m log(n/m)) comparisons are done.
+ *  Otherwise, the operands are merged by SIMD kernels (SSE4.2 or AVX2, see flatsimd.h),
+ *  selected for the running CPU.
+ *  parallel_union, parallel_intersection and parallel_difference split one large operation
+ *  between the threads of a ThreadPool (merge path).
+ */
+class FlatSet {
+public:
+    /*
+     * Default constructor: create an empty FlatSet.
+     */
+    FlatSet() = default;
+
+    /*
+     * Conversion constructor: convert val into a singleton {val}.
+     */
+    FlatSet(int val) : values{val} {
+    }
+
+    /*
+     * Constructor to create a FlatSet from a vector of ints.
+     * \param list_of_values is usually an increasingly sorted vector of unique ints,
+     * otherwise it is sorted and its repetitions are removed.
+     */
+    explicit FlatSet(const std::vector<int>& list_of_values);
+
+    /*
+     * Transform the FlatSet into an empty set.
+     * The memory of the FlatSet is kept, to be reused.
+     */
+    void make_empty() {
+        values.clear();
+    }
+
+    /*
+     * Test whether val belongs to the FlatSet (binary search).
+     * Return true if val belongs to the set, otherwise false.
+     */
+    bool is_member(int val) const;
+
+    /*
+     * Test whether each value of sorted_queries belongs to the FlatSet.
+     * Return a vector with element i true if sorted_queries[i] belongs to the set.
+     * Requirement: sorted_queries is sorted in non-decreasing order.
+     * A single pass over the FlatSet, comparing a query with a block of values at once
+     * and galloping over long gaps.
+     */
+    std::vector<bool> are_members(std::span<const int> sorted_queries) const;
+
+    /*
+     * Test whether the FlatSet is empty.
+     */
+    bool is_empty() const {
+        return values.empty();
+    }
+
+    /*
+     * Count the number of values stored in the FlatSet.
+     */
+    size_t cardinality() const {
+        return values.size();
+    }
+
+    /*
+     * Three-way comparison operator, with the same semantics as Set::operator<=>.
+     * Return std::partial_ordering::equivalent if *this == S.
+     * Return std::partial_ordering::less if *this < S (*this is contained in S).
+     * Return std::partial_ordering::greater if *this > S (*this contains S).
+     * Return std::partial_ordering::unordered otherwise.
+     */
+    std::partial_ordering operator<=>(const FlatSet& S) const;
+
+    /*
+     * Test whether FlatSet *this and S represent the same set.
+     */
+    bool operator==(const FlatSet& S) const {
+        return values == S.values;
+    }
+
+    /*
+     * Modify FlatSet *this such that it becomes the union of *this with S.
+     */
+    FlatSet& operator+=(const FlatSet& S);
+
+    /*
+     * Modify FlatSet *this such that it becomes the intersection of *this with S.
+     */
+    FlatSet& operator*=(const FlatSet& S);
+
+    /*
+     * Modify FlatSet *this such that it becomes the set difference between *this and S.
+     */
+    FlatSet& operator-=(const FlatSet& S);
+
+    /*
+     * Same as operator+=, operator*= and operator-=, computed on the threads of pool
+     * (by default, ThreadPool::shared()).
+     * Both vectors are split at co-ranked positions (merge path): slice t holds the values
+     * at positions [t * N / p, (t + 1) * N / p) of the merge of *this and S, N values in total,
+     * so that each thread merges the same number of values, independently of the others.
+     * The slices are then copied side by side into the result.
+     * Small operands (fewer than parallel_threshold values) and operands of skewed sizes
+     * (see use_gallop) are handled by the sequential operators.
+     */
+    FlatSet& parallel_union(const FlatSet& S, ThreadPool& pool);
+    FlatSet& parallel_union(const FlatSet& S);
+    FlatSet& parallel_intersection(const FlatSet& S, ThreadPool& pool);
+    FlatSet& parallel_intersection(const FlatSet& S);
+    FlatSet& parallel_difference(const FlatSet& S, ThreadPool& pool);
+    FlatSet& parallel_difference(const FlatSet& S);
+
+    /* *******************************************
+     * Overloaded operators: non-member functions *
+     * ******************************************* */
+
+    /*
+     * Overloaded operator<<, writes S with the same format as a Set.
+     */
+    friend std::ostream& operator<<(std::ostream& os, const FlatSet& S) {
+        S.write_to_stream(os);
+        return os;
+    }
+
+    /*
+     * Overloaded operator+: FlatSet union S1 + S2.
+     */
+    friend FlatSet operator+(FlatSet S1, const FlatSet& S2) {
+        return (S1 += S2);
+    }
+
+    /*
+     * Overloaded operator*: FlatSet intersection S1 * S2.
+     */
+    friend FlatSet operator*(FlatSet S1, const FlatSet& S2) {
+        return (S1 *= S2);
+    }
+
+    /*
+     * Overloaded operator-: FlatSet difference S1 - S2.
+     */
+    friend FlatSet operator-(FlatSet S1, const FlatSet& S2) {
+        return (S1 -= S2);
+    }
+
+private:
+    /*
+     * Galloping is used when the larger operand has at least
+     * gallop_ratio times more values than the smaller one.
+     */
+    static constexpr size_t gallop_ratio = 32;
+
+    /*
+     * The parallel operations split operands with at least this many values in total,
+     * smaller ones are not worth waking up the threads.
+     */
+    static constexpr size_t parallel_threshold = size_t{1} << 16;
+
+    std::vector<int> values;  // Increasingly sorted, without repetitions.
+
+    /*
+     * Return true if the sizes n1 and n2 are skewed enough for galloping.
+     */
+    static bool use_gallop(size_t n1, size_t n2) {
+        return n1 / gallop_ratio > n2 || n2 / gallop_ratio > n1;
+    }
+
+    /*
+     * Return true if the parallel operations should split *this and S between threads.
+     */
+    bool use_parallel(const FlatSet& S) const {
+        return this != &S && values.size() + S.values.size() >= parallel_threshold &&
+               !use_gallop(values.size(), S.values.size());
+    }
+
+    /*
+     * Replace values by the results of merge(a, na, b, nb, out) (a kernel of flatsimd.h) over
+     * the merge-path slices of *this and S, one slice per thread of pool.
+     */
+    template <class Merge>
+    void merge_in_slices(const FlatSet& S, ThreadPool& pool, Merge merge);
+
+    /*
+     * Write FlatSet *this to stream os.
+     */
+    void write_to_stream(std::ostream& os) const;
+};
@@ -0,0 +1,479 @@
+#include "flatsimd.h"
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstdint>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define FLAT_SIMD_X86 1
+#include <immintrin.h>
+#endif
+
+namespace flat_simd {
+
+namespace {
+
+/*****************************************************
+ * Scalar kernels, also used for the tails            *
+ ******************************************************/
+
+/*
+ * Return the first position in [p, n) whose value is not less than val:
+ * exponential search from p, then binary search of the last gap.
+ */
+std::size_t gallop(const int* a, std::size_t p, std::size_t n, int val) {
+    std::size_t bound = 1;
+    while (p + bound < n && a[p + bound] < val) {
+        bound *= 2;
+    }
+    return static_cast<std::size_t>(std::lower_bound(a + p + bound / 2, a + std::min(p + bound, n), val) - a);
+}
+
+/*
+ * Merge a with b and write the values of a that belong to b (keep == true), or do not (keep == false).
+ * The values a[i], i < 32, whose bit i is set in found are already known to belong to b
+ * (a SIMD kernel found them in earlier blocks of b): they are not searched again.
+ */
+std::size_t filter_tail(const int* a, std::size_t na, const int* b, std::size_t nb, int* out, std::uint32_t found,
+                        bool keep) {
+    int* const out_begin = out;
+    std::size_t j = 0;
+    for (std::size_t i = 0; i < na; ++i) {
+        bool member;
+        if (i < 32 && ((found >> i) & 1) != 0) {
+            member = true;
+        } else {
+            if (j == nb && keep && (i >= 32 || (found >> i) == 0)) break;  // nothing left to keep
+            while (j < nb && b[j] < a[i]) ++j;
+            member = j < nb && b[j] == a[i];
+        }
+        if (member == keep) *out++ = a[i];
+    }
+    return static_cast<std::size_t>(out - out_begin);
+}
+
+std::size_t intersect_scalar(const int* a, std::size_t na, const int* b, std::size_t nb, int* out) {
+    return filter_tail(a, na, b, nb, out, 0, true);
+}
+
+std::size_t difference_scalar(const int* a, std::size_t na, const int* b, std::size_t nb, int* out) {
+    return filter_tail(a, na, b, nb, out, 0, false);
+}
+
+/*
+ * Union of the three sorted sequences p, a and b, without the value last (if has_last) nor repetitions.
+ * p holds the values still in the registers of a SIMD union.
+ */
+std::size_t unite_tail(const int* p, std::size_t np, const int* a, std::size_t na, const int* b, std::size_t nb,
+                       int* out, bool has_last, int last) {
+    int* const out_begin = out;
+    std::size_t i = 0, j = 0, k = 0;
+    while (i < np || j < na || k < nb) {
+        int val = i < np ? p[i] : (j < na ? a[j] : b[k]);
+        if (j < na && a[j] < val) val = a[j];
+        if (k < nb && b[k] < val) val = b[k];
+        if (i < np && p[i] == val) ++i;
+        if (j < na && a[j] == val) ++j;
+        if (k < nb && b[k] == val) ++k;
+        if (!has_last || val != last) *out++ = val;
+        has_last = true;
+        last = val;
+    }
+    return static_cast<std::size_t>(out - out_begin);
+}
+
+std::size_t unite_scalar(const int* a, std::size_t na, const int* b, std::size_t nb, int* out) {
+    return static_cast<std::size_t>(std::set_union(a, a + na, b, b + nb, out) - out);
+}
+
+/*
+ * For each query, step through a from the position of the previous query, and gallop
+ * after max_steps values: O(min(d, log d)) time for a distance d.
+ */
+void are_members_scalar(const int* a, std::size_t na, const int* queries, std::size_t nq, unsigned char* found) {
+    constexpr int max_steps = 32;
+    std::size_t p = 0;
+    for (std::size_t k = 0; k < nq; ++k) {
+        int q = queries[k];
+        for (int steps = 0; p < na && a[p] < q; ++p) {
+            if (++steps == max_steps) {
+                p = gallop(a, p, na, q);
+                break;
+            }
+        }
+        found[k] = p < na && a[p] == q;
+    }
+}
+
+constexpr Kernels scalar_kernels{"scalar", intersect_scalar, difference_scalar, unite_scalar, are_members_scalar};
+
+#ifdef FLAT_SIMD_X86
+
+/*****************************************************
+ * Shuffle tables                                     *
+ ******************************************************/
+
+/*
+ * Byte shuffle (pshufb) that moves the lanes selected by a 4 bit mask to the front.
+ */
+constexpr std::array<std::array<std::uint8_t, 16>, 16> compact4_table = [] {
+    std::array<std::array<std::uint8_t, 16>, 16> table{};
+    for (unsigned mask = 0; mask < 16; ++mask) {
+        unsigned n = 0;
+        for (unsigned lane = 0; lane < 4; ++lane) {
+            if ((mask >> lane) & 1) {
+                for (unsigned byte = 0; byte < 4; ++byte) {
+                    table[mask][4 * n + byte] = static_cast<std::uint8_t>(4 * lane + byte);
+                }
+                ++n;
+            }
+        }
+        for (unsigned byte = 4 * n; byte < 16; ++byte) {
+            table[mask][byte] = 0x80;  // zero
+        }
+    }
+    return table;
+}();
+
+/*
+ * Lane permutation (vpermd) that moves the lanes selected by an 8 bit mask to the front.
+ */
+constexpr std::array<std::array<std::int32_t, 8>, 256> compact8_table = [] {
+    std::array<std::array<std::int32_t, 8>, 256> table{};
+    for (unsigned mask = 0; mask < 256; ++mask) {
+        unsigned n = 0;
+        for (unsigned lane = 0; lane < 8; ++lane) {
+            if ((mask >> lane) & 1) table[mask][n++] = static_cast<std::int32_t>(lane);
+        }
+    }
+    return table;
+}();
+
+/*****************************************************
+ * SSE4.2 kernels (4 lanes)                           *
+ ******************************************************/
+
+__attribute__((target("sse4.2,popcnt"))) inline __m128i compact4(__m128i v, unsigned mask) {
+    return _mm_shuffle_epi8(v, _mm_loadu_si128(reinterpret_cast<const __m128i*>(compact4_table[mask].data())));
+}
+
+/*
+ * The block of a is written when a moves to its next block, with the lanes found in any block
+ * of b so far (intersection), or the others (difference). The store writes 4 lanes at out, which
+ * is never after the block of a: the values overwritten in place were already loaded.
+ */
+__attribute__((target("sse4.2,popcnt"))) std::size_t filter_sse42(const int* a, std::size_t na, const int* b,
+                                                                   std::size_t nb, int* out, bool keep) {
+    int* const out_begin = out;
+    std::size_t i = 0, j = 0;
+    std::uint32_t found = 0;
+    if (na >= 4 && nb >= 4) {
+        __m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+        __m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+        while (true) {
+            __m128i eq0 = _mm_cmpeq_epi32(va, vb);
+            __m128i eq1 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0, 3, 2, 1)));
+            __m128i eq2 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1, 0, 3, 2)));
+            __m128i eq3 = _mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2, 1, 0, 3)));
+            __m128i eq = _mm_or_si128(_mm_or_si128(eq0, eq1), _mm_or_si128(eq2, eq3));
+            found |= static_cast<std::uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(eq)));
+
+            int a_max = a[i + 3];
+            int b_max = b[j + 3];
+            if (a_max <= b_max) {
+                unsigned emit = keep ? found : (~found & 0xF);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out), compact4(va, emit));
+                out += std::popcount(emit);
+                found = 0;
+                i += 4;
+                if (i + 4 > na) break;
+                va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            }
+            if (b_max <= a_max) {
+                j += 4;
+                if (j + 4 > nb) break;
+                vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+            }
+        }
+    }
+    out += filter_tail(a + i, na - i, b + j, nb - j, out, found, keep);
+    return static_cast<std::size_t>(out - out_begin);
+}
+
+std::size_t intersect_sse42(const int* a, std::size_t na, const int* b, std::size_t nb, int* out) {
+    return filter_sse42(a, na, b, nb, out, true);
+}
+
+std::size_t difference_sse42(const int* a, std::size_t na, const int* b, std::size_t nb, int* out) {
+    return filter_sse42(a, na, b, nb, out, false);
+}
+
+/*
+ * Merge network: lo and hi sorted, on return lo holds the 4 smallest values sorted, hi the 4 largest.
+ */
+__attribute__((target("sse4.2,popcnt"))) inline void merge4(__m128i& lo, __m128i& hi) {
+    for (int r = 0; r < 4; ++r) {
+        __m128i mn = _mm_min_epi32(lo, hi);
+        hi = _mm_max_epi32(lo, hi);
+        lo = _mm_shuffle_epi32(mn, _MM_SHUFFLE(0, 3, 2, 1));
+    }
+}
+
+/*
+ * Write the sorted values of v that differ from their predecessor (last, for the first lane).
+ */
+__attribute__((target("sse4.2,popcnt"))) inline int* emit4(__m128i v, int* out, bool& has_last, int& last) {
+    __m128i prev = _mm_alignr_epi8(v, _mm_set1_epi32(last), 12);
+    unsigned mask = ~static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(v, prev)))) & 0xF;
+    if (!has_last) mask |= 1;
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(out), compact4(v, mask));
+    has_last = true;
+    last = _mm_extract_epi32(v, 3);
+    return out + std::popcount(mask);
+}
+
+/*
+ * Keep the 4 largest values merged so far in hi, and merge them with the next block of the list
+ * with the smaller next value: the 4 smallest are then smaller than all values left.
+ */
+__attribute__((target("sse4.2,popcnt"))) std::size_t unite_sse42(const int* a, std::size_t na, const int* b,
+                                                                  std::size_t nb, int* out) {
+    if (na < 4 || nb < 4) return unite_scalar(a, na, b, nb, out);
+    int* const out_begin = out;
+    bool has_last = false;
+    int last = 0;
+
+    __m128i lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+    __m128i hi = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+    std::size_t i = 4, j = 4;
+    merge4(lo, hi);
+    out = emit4(lo, out, has_last, last);
+    while (i + 4 <= na && j + 4 <= nb) {
+        if (a[i] <= b[j]) {
+            lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            i += 4;
+        } else {
+            lo = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + j));
+            j += 4;
+        }
+        merge4(lo, hi);
+        out = emit4(lo, out, has_last, last);
+    }
+
+    int pending[4];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(pending), hi);
+    out += unite_tail(pending, 4, a + i, na - i, b + j, nb - j, out, has_last, last);
+    return static_cast<std::size_t>(out - out_begin);
+}
+
+/*
+ * Step through a 4 values at a time: the number of lanes smaller than the query is
+ * its position in the block, unless all are smaller.
+ */
+__attribute__((target("sse4.2,popcnt"))) void are_members_sse42(const int* a, std::size_t na, const int* queries,
+                                                                 std::size_t nq, unsigned char* found) {
+    constexpr int max_blocks = 8;
+    std::size_t p = 0;
+    for (std::size_t k = 0; k < nq; ++k) {
+        int q = queries[k];
+        __m128i vq = _mm_set1_epi32(q);
+        int blocks = 0;
+        while (p + 4 <= na) {
+            __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + p));
+            unsigned smaller = static_cast<unsigned>(_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(vq, block))));
+            if (smaller != 0xF) {
+                p += static_cast<std::size_t>(std::popcount(smaller));
+                break;
+            }
+            p += 4;
+            if (++blocks == max_blocks) {
+                p = gallop(a, p, na, q);
+                break;
+            }
+        }
+        while (p < na && a[p] < q) ++p;
+        found[k] = p < na && a[p] == q;
+    }
+}
+
+constexpr Kernels sse42_kernels{"sse4.2", intersect_sse42, difference_sse42, unite_sse42, are_members_sse42};
+
+/*****************************************************
+ * AVX2 kernels (8 lanes)                             *
+ ******************************************************/
+
+__attribute__((target("avx2,popcnt"))) inline __m256i compact8(__m256i v, unsigned mask) {
+    return _mm256_permutevar8x32_epi32(
+        v, _mm256_loadu_si256(reinterpret_cast<const __m256i*>(compact8_table[mask].data())));
+}
+
+/*
+ * Same as filter_sse42, with 8 lanes: b is rotated 7 times by a lane permutation.
+ */
+__attribute__((target("avx2,popcnt"))) std::size_t filter_avx2(const int* a, std::size_t na, const int* b,
+                                                               std::size_t nb, int* out, bool keep) {
+    int* const out_begin = out;
+    std::size_t i = 0, j = 0;
+    std::uint32_t found = 0;
+    if (na >= 8 && nb >= 8) {
+        const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+        __m256i va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+        __m256i vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+        while (true) {
+            __m256i eq = _mm256_cmpeq_epi32(va, vb);
+            __m256i r = vb;
+            for (int k = 1; k < 8; ++k) {
+                r = _mm256_permutevar8x32_epi32(r, rotate);
+                eq = _mm256_or_si256(eq, _mm256_cmpeq_epi32(va, r));
+            }
+            found |= static_cast<std::uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(eq)));
+
+            int a_max = a[i + 7];
+            int b_max = b[j + 7];
+            if (a_max <= b_max) {
+                unsigned emit = keep ? found : (~found & 0xFF);
+                _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), compact8(va, emit));
+                out += std::popcount(emit);
+                found = 0;
+                i += 8;
+                if (i + 8 > na) break;
+                va = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            }
+            if (b_max <= a_max) {
+                j += 8;
+                if (j + 8 > nb) break;
+                vb = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+            }
+        }
+    }
+    out += filter_tail(a + i, na - i, b + j, nb - j, out, found, keep);
+    return static_cast<std::size_t>(out - out_begin);
+}
+
+std::size_t intersect_avx2(const int* a, std::size_t na, const int* b, std::size_t nb, int* out) {
+    return filter_avx2(a, na, b, nb, out, true);
+}
+
+std::size_t difference_avx2(const int* a, std::size_t na, const int* b, std::size_t nb, int* out) {
+    return filter_avx2(a, na, b, nb, out, false);
+}
+
+__attribute__((target("avx2,popcnt"))) inline void merge8(__m256i& lo, __m256i& hi) {
+    const __m256i rotate = _mm256_setr_epi32(1, 2, 3, 4, 5, 6, 7, 0);
+    for (int r = 0; r < 8; ++r) {
+        __m256i mn = _mm256_min_epi32(lo, hi);
+        hi = _mm256_max_epi32(lo, hi);
+        lo = _mm256_permutevar8x32_epi32(mn, rotate);
+    }
+}
+
+__attribute__((target("avx2,popcnt"))) inline int* emit8(__m256i v, int* out, bool& has_last, int& last) {
+    const __m256i shift = _mm256_setr_epi32(0, 0, 1, 2, 3, 4, 5, 6);
+    __m256i prev = _mm256_blend_epi32(_mm256_permutevar8x32_epi32(v, shift), _mm256_set1_epi32(last), 1);
+    unsigned mask = ~static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(v, prev)))) & 0xFF;
+    if (!has_last) mask |= 1;
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(out), compact8(v, mask));
+    has_last = true;
+    last = _mm256_extract_epi32(v, 7);
+    return out + std::popcount(mask);
+}
+
+__attribute__((target("avx2,popcnt"))) std::size_t unite_avx2(const int* a, std::size_t na, const int* b,
+                                                              std::size_t nb, int* out) {
+    if (na < 8 || nb < 8) return unite_sse42(a, na, b, nb, out);
+    int* const out_begin = out;
+    bool has_last = false;
+    int last = 0;
+
+    __m256i lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a));
+    __m256i hi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b));
+    std::size_t i = 8, j = 8;
+    merge8(lo, hi);
+    out = emit8(lo, out, has_last, last);
+    while (i + 8 <= na && j + 8 <= nb) {
+        if (a[i] <= b[j]) {
+            lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + i));
+            i += 8;
+        } else {
+            lo = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + j));
+            j += 8;
+        }
+        merge8(lo, hi);
+        out = emit8(lo, out, has_last, last);
+    }
+
+    int pending[8];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(pending), hi);
+    out += unite_tail(pending, 8, a + i, na - i, b + j, nb - j, out, has_last, last);
+    return static_cast<std::size_t>(out - out_begin);
+}
+
+__attribute__((target("avx2,popcnt"))) void are_members_avx2(const int* a, std::size_t na, const int* queries,
+                                                             std::size_t nq, unsigned char* found) {
+    constexpr int max_blocks = 4;
+    std::size_t p = 0;
+    for (std::size_t k = 0; k < nq; ++k) {
+        int q = queries[k];
+        __m256i vq = _mm256_set1_epi32(q);
+        int blocks = 0;
+        while (p + 8 <= na) {
+            __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + p));
+            unsigned smaller =
+                static_cast<unsigned>(_mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpgt_epi32(vq, block))));
+            if (smaller != 0xFF) {
+                p += static_cast<std::size_t>(std::popcount(smaller));
+                break;
+            }
+            p += 8;
+            if (++blocks == max_blocks) {
+                p = gallop(a, p, na, q);
+                break;
+            }
+        }
+        while (p < na && a[p] < q) ++p;
+        found[k] = p < na && a[p] == q;
+    }
+}
+
+constexpr Kernels avx2_kernels{"avx2", intersect_avx2, difference_avx2, unite_avx2, are_members_avx2};
+
+#endif  // FLAT_SIMD_X86
+
+}  // namespace
+
+bool supported(Isa isa) {
+    switch (isa) {
+        case Isa::scalar:
+            return true;
+#ifdef FLAT_SIMD_X86
+        case Isa::sse42:
+            return __builtin_cpu_supports("sse4.2") && __builtin_cpu_supports("popcnt");
+        case Isa::avx2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("popcnt");
+#endif
+        default:
+            return false;
+    }
+}
+
+const Kernels& kernels(Isa isa) {
+    switch (isa) {
+#ifdef FLAT_SIMD_X86
+        case Isa::sse42:
+            return sse42_kernels;
+        case Isa::avx2:
+            return avx2_kernels;
+#endif
+        default:
+            return scalar_kernels;
+    }
+}
+
+const Kernels& kernels() {
+    static const Kernels& best = supported(Isa::avx2)    ? kernels(Isa::avx2)
+                                 : supported(Isa::sse42) ? kernels(Isa::sse42)
+                                                         : kernels(Isa::scalar);
+    return best;
+}
+
+}  // namespace flat_simd
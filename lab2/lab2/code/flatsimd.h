@@ -0,0 +1,64 @@
+#pragma once
+
+#include <cstddef>
+
+/*
+ * Kernels of FlatSet on increasingly sorted arrays of unique ints, in several instruction sets.
+ *
+ * The SIMD kernels compare a block of W values of a (W = 4 for SSE4.2, 8 for AVX2) with a block
+ * of b, all W x W pairs at once (b is rotated W times), and write the selected values of a
+ * with a single shuffle from a table indexed by the bit mask of the selected lanes
+ * (block compare, as in Schlegel et al. and Lemire et al.).
+ * The union merges blocks with a network of min/max (Inoue et al.).
+ * The SIMD kernels exist only for x86 with GCC or Clang, elsewhere only the scalar ones are available.
+ * kernels() returns the best kernels supported by the running CPU, chosen on the first call.
+ */
+namespace flat_simd {
+
+enum class Isa { scalar, sse42, avx2 };
+
+struct Kernels {
+    const char* name;
+
+    /*
+     * Write the values of a that belong to b to out, and return their number.
+     * out may be a (the result is compacted in place), otherwise it must not overlap a or b
+     * and must have room for na values.
+     */
+    std::size_t (*intersect)(const int* a, std::size_t na, const int* b, std::size_t nb, int* out);
+
+    /*
+     * Write the values of a that do not belong to b to out, and return their number.
+     * Same requirements on out as intersect.
+     */
+    std::size_t (*difference)(const int* a, std::size_t na, const int* b, std::size_t nb, int* out);
+
+    /*
+     * Write the union of a and b to out, and return its size.
+     * out must not overlap a or b, and must have room for na + nb values.
+     */
+    std::size_t (*unite)(const int* a, std::size_t na, const int* b, std::size_t nb, int* out);
+
+    /*
+     * Set found[i] to 1 if queries[i] belongs to a, otherwise to 0.
+     * Requirement: queries is sorted in non-decreasing order.
+     */
+    void (*are_members)(const int* a, std::size_t na, const int* queries, std::size_t nq, unsigned char* found);
+};
+
+/*
+ * Test whether the running CPU (and the compiler) supports isa.
+ */
+bool supported(Isa isa);
+
+/*
+ * Return the kernels of isa. Requirement: supported(isa).
+ */
+const Kernels& kernels(Isa isa);
+
+/*
+ * Return the kernels of the best instruction set supported by the running CPU.
+ */
+const Kernels& kernels();
+
+}  // namespace flat_simd
@@ -0,0 +1,115 @@
+/*
+ * Throughput of the FlatSet kernels (see flatsimd.h) in each instruction set supported by the CPU.
+ *
+ * Two sorted arrays of n unique values each, drawn from [0, density * n), are intersected,
+ * subtracted and united, and n sorted queries drawn from the same range are tested with
+ * are_members. A lower density gives more common values (and shorter runs between them).
+ * Results are in input elements per second (both operands, or the array and the queries),
+ * best of a few runs, written to stdout as JSON.
+ *
+ * Usage: KernelBench [--size n]     (build in Release mode)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "flatsimd.h"
+
+namespace {
+
+constexpr int repetitions = 5;
+
+size_t sink = 0;  // result sizes are added here, so that work is not optimized away
+
+struct Result {
+    std::string kernel;
+    std::string isa;
+    int density;
+    double elements_per_second;
+};
+
+/*
+ * Best time of f over the repetitions, in seconds.
+ */
+template <class F>
+double best_seconds(F f) {
+    double best = 1e300;
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        sink += f();
+        std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+std::vector<int> sorted_unique(int n, int range, unsigned seed) {
+    std::mt19937 rng{seed};
+    std::uniform_int_distribution<int> value(0, range - 1);
+    std::vector<int> v;
+    for (int i = 0; i < n; ++i) v.push_back(value(rng));
+    std::sort(v.begin(), v.end());
+    v.erase(std::unique(v.begin(), v.end()), v.end());
+    return v;
+}
+
+void write_json(std::ostream& os, const std::vector<Result>& results, int n) {
+    os << "{\n  \"size\": " << n << ",\n  \"best\": \"" << flat_simd::kernels().name << "\",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        os << "    {\"kernel\": \"" << r.kernel << "\", \"isa\": \"" << r.isa << "\", \"density\": " << r.density
+           << ", \"elements_per_second\": " << r.elements_per_second << "}" << (i + 1 < results.size() ? "," : "")
+           << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int n = 1000000;
+    for (int i = 1; i < argc; i += 2) {
+        std::string option{argv[i]};
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value != nullptr && option == "--size") {
+            n = std::atoi(value);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--size n]\n";
+            return 2;
+        }
+    }
+
+    std::vector<Result> results;
+    for (int density : {2, 8}) {
+        const std::vector<int> a = sorted_unique(n, density * n, 1);
+        const std::vector<int> b = sorted_unique(n, density * n, 2);
+        const std::vector<int> queries = sorted_unique(n, density * n, 3);
+        const double elements = static_cast<double>(a.size() + b.size());
+        std::vector<int> out(a.size() + b.size());
+        std::vector<unsigned char> found(queries.size());
+
+        for (auto isa : {flat_simd::Isa::scalar, flat_simd::Isa::sse42, flat_simd::Isa::avx2}) {
+            if (!flat_simd::supported(isa)) continue;
+            const flat_simd::Kernels& K = flat_simd::kernels(isa);
+
+            double t = best_seconds([&] { return K.intersect(a.data(), a.size(), b.data(), b.size(), out.data()); });
+            results.push_back({"intersect", K.name, density, elements / t});
+            t = best_seconds([&] { return K.difference(a.data(), a.size(), b.data(), b.size(), out.data()); });
+            results.push_back({"difference", K.name, density, elements / t});
+            t = best_seconds([&] { return K.unite(a.data(), a.size(), b.data(), b.size(), out.data()); });
+            results.push_back({"unite", K.name, density, elements / t});
+            t = best_seconds([&] {
+                K.are_members(a.data(), a.size(), queries.data(), queries.size(), found.data());
+                return static_cast<size_t>(std::count(found.begin(), found.end(), 1));
+            });
+            results.push_back({"are_members", K.name, density, static_cast<double>(a.size() + queries.size()) / t});
+        }
+    }
+
+    write_json(std::cout, results, n);
+}
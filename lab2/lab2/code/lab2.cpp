@@ -2,8 +2,26 @@
 #include <iomanip>
 #include <sstream>
 #include <cassert>
+#include <unordered_map>
+#include <algorithm>
+#include <ranges>
+#include <numeric>
+#include <string>
+#include <memory_resource>
+#include <thread>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
 
 #include "set.h"
+#include "flatset.h"
+#include "flatsimd.h"
+#include "roaringset.h"
+#include "unrolledset.h"
+#include "setpool.h"
+#include "concurrentset.h"
+#include "setfile.h"
+#include "threadpool.h"
 
 int main() {
     /*****************************************************
@@ -311,5 +329,879 @@ int main() {
     }
     assert(Set::get_count_nodes() == 0);
 
+    /*****************************************************
+     * TEST PHASE 10                                      *
+     * Move constructor, move assignment, and union       *
+     * with a temporary Set                               *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 10: move semantics\n";
+
+    {
+        std::vector<int> A1{1, 3, 5, 8};
+        std::vector<int> A2{2, 3, 7, 9, 10};
+
+        Set S1{A1};
+        Set S2{std::move(S1)};  // S1 becomes empty
+        assert(S1.is_empty());
+        assert(Set::get_count_nodes() == 8);
+
+        S1 = std::move(S2);
+        assert(S2.is_empty());
+        assert(Set::get_count_nodes() == 8);
+
+        S1 += Set{A2};  // values 2, 7, 9, 10 are added to S1
+        assert(Set::get_count_nodes() == 12);
+
+        // test
+        std::vector<int> A3{1, 2, 3, 5, 7, 8, 9, 10};
+        assert(S1 == Set{A3});
+
+        S1 += S1 * Set{A2};
+        assert(Set::get_count_nodes() == 12);
+        assert(S1 == Set{A3});
+    }
+    assert(Set::get_count_nodes() == 0);
+
+    /*****************************************************
+     * TEST PHASE 11                                      *
+     * FlatSet: same interface as Set                     *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 11: FlatSet\n";
+
+    {
+        std::vector<int> A1{1, 3, 5, 8};
+        std::vector<int> A2{2, 3, 7};
+
+        FlatSet S1{A1};
+        FlatSet S2{A2};
+        FlatSet S3{S1};
+
+        // Test
+        std::ostringstream os{};
+        os << FlatSet{} << ' ' << FlatSet{-4} << ' ' << S3;
+
+        std::string tmp{os.str()};
+        assert((tmp == std::string{"Set is empty! { -4 } { 1 3 5 8 }"}));
+
+        assert(S1.is_member(5));
+        assert(S1.is_member(4) == false);
+        assert(S1.cardinality() == 4);
+
+        assert(FlatSet(std::vector<int>{3, 5}) <= S1);
+        assert((S1 <= S2) == false);
+        assert((S1 >= S2) == false);
+        assert(S1 == S3);
+
+        S3 += S2;
+        assert(S3 == FlatSet(std::vector<int>{1, 2, 3, 5, 7, 8}));
+
+        S3 *= S2;
+        assert(S3 == S2);
+
+        S3 -= 3;
+        assert(S3 == FlatSet(std::vector<int>{2, 7}));
+
+        assert((4 - S1 - 5 - (S1 + S2) - 99999) == FlatSet{4});
+        assert((3 * S2 + 4) == FlatSet(std::vector<int>{3, 4}));
+        assert((S1 - S2) == FlatSet(std::vector<int>{1, 5, 8}));
+
+        S3.make_empty();
+        assert(S3.is_empty());
+
+        FlatSet S4{};
+        S4 = S3 = S2;
+        assert(S4 == S2 && S3 == S2);
+        assert((S1 < S1) == false && (S1 > S1) == false && S1 != S2);
+        assert(3 < FlatSet(std::vector<int>{3, 5, 8}) && FlatSet{10} == 10 && 10 == FlatSet{10});
+        assert((S2 - 2 + FlatSet(std::vector<int>{3, 4}) + 24) == FlatSet(std::vector<int>{3, 4, 7, 24}));
+        S4 += 6;
+        assert(S4 == FlatSet(std::vector<int>{2, 3, 6, 7}));
+        assert(FlatSet(std::vector<int>{7, 3, 7, 1}) == FlatSet(std::vector<int>{1, 3, 7}));  // sorted, unique
+        S4 -= S4;
+        assert(S4.is_empty());
+
+        FlatSet S5{std::move(S1)};  // S1 becomes empty
+        assert(S1.is_empty());
+        S1 = std::move(S5);
+        S1 += FlatSet{A2};
+        assert(S1 == FlatSet(std::vector<int>{1, 2, 3, 5, 7, 8}));
+        S1 += S1 * FlatSet{A2};
+        assert(S1 == FlatSet(std::vector<int>{1, 2, 3, 5, 7, 8}));
+    }
+
+    /*****************************************************
+     * TEST PHASE 12                                      *
+     * RoaringSet: compressed Set, conversions to and     *
+     * from Set                                           *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 12: RoaringSet\n";
+
+    {
+        std::vector<int> A1;  // dense: 0..199999 without multiples of 7
+        std::vector<int> A2;  // dense range with a few negative values
+        for (int i = 0; i < 200000; ++i) {
+            if (i % 7 != 0) A1.push_back(i);
+        }
+        for (int i = -10; i < 150000; ++i) {
+            if (i < 0 || i % 1000 != 0) A2.push_back(i);
+        }
+
+        Set S1{A1};
+        RoaringSet R1{S1};
+        RoaringSet R2{A2};
+        R2.run_optimize();
+
+        // Test
+        assert(R1.cardinality() == A1.size());
+        assert(R1.is_member(8));
+        assert(R1.is_member(7) == false);
+        assert(R2.is_member(-10));
+        assert(R1.to_set() == S1);
+
+        RoaringSet U = R1 + R2;
+        assert(U.to_set() == (S1 + Set{A2}));
+
+        RoaringSet I = R1 * R2;
+        assert(I.to_set() == (S1 * Set{A2}));
+        assert(I <= R1 && I <= R2);
+
+        RoaringSet D = R1 - R2;
+        assert(D.to_set() == (S1 - Set{A2}));
+        assert((D * R2).is_empty());
+
+        std::ostringstream os{};
+        os << RoaringSet{} << ' ' << RoaringSet{std::vector<int>{-70000, 3, 100000}};
+
+        std::string tmp{os.str()};
+        assert((tmp == std::string{"Set is empty! { -70000 3 100000 }"}));
+    }
+    assert(Set::get_count_nodes() == 0);
+
+    /*****************************************************
+     * TEST PHASE 13                                      *
+     * insert, erase, and is_member on an indexed Set     *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 13: insert and erase\n";
+
+    {
+        std::vector<int> A1;
+        for (int i = 0; i < 1000; ++i) {
+            A1.push_back(2 * i);
+        }
+
+        Set S1{A1};
+        assert(S1.is_member(1998));
+        assert(S1.is_member(999) == false);
+
+        assert(S1.insert(999));
+        assert(S1.insert(999) == false);
+        assert(S1.is_member(999));
+        assert(Set::get_count_nodes() == 1005);  // with the dummy nodes of the Set and of its Shared body
+
+        assert(S1.erase(0));
+        assert(S1.erase(0) == false);
+        assert(S1.is_member(0) == false);
+
+        S1 += -5;  // singleton: same as insert
+        S1 -= 1998;  // singleton: same as erase
+        assert(S1.is_member(-5));
+        assert(S1.is_member(1998) == false);
+        assert(S1.cardinality() == 1000);
+
+        S1 *= Set{A1};  // the index is rebuilt after the intersection
+        assert(S1.cardinality() == 998);
+        assert(S1.is_member(2) && S1.is_member(999) == false);
+
+        Set S2{};
+        assert(S2.insert(3) && S2.insert(1) && S2.insert(2));
+        assert(S2 == Set(std::vector<int>{1, 2, 3}));
+    }
+    assert(Set::get_count_nodes() == 0);
+
+
+    /*****************************************************
+     * TEST PHASE 14                                      *
+     * UnrolledSet: several values per list node          *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 14: UnrolledSet\n";
+
+    {
+        std::vector<int> A1;
+        std::vector<int> A2;
+        for (int i = 0; i < 1000; ++i) {
+            A1.push_back(2 * i);
+            A2.push_back(3 * i);
+        }
+
+        UnrolledSet U1{A1};
+        UnrolledSet U2{A2};
+
+        // Test
+        assert(U1.cardinality() == 1000);
+        assert(U1.is_member(1998) && U1.is_member(999) == false);
+
+        assert((U1 + U2).cardinality() == Set(Set{A1} + Set{A2}).cardinality());
+        std::vector<int> multiples_of_6;
+        for (int i = 0; i < 2000; i += 6) {
+            multiples_of_6.push_back(i);
+        }
+        assert((U1 * U2) == UnrolledSet{multiples_of_6});
+        assert((U1 * U2).cardinality() == 334);
+        assert((U1 - U2).cardinality() == 666);
+        assert((U1 * U2) <= U1 && (U1 * U2) <= U2);
+        assert(((U1 - U2) <=> U2) == std::partial_ordering::unordered);
+
+        // insert and erase split and merge the blocks
+        UnrolledSet U3{};
+        for (int i = 99; i >= 0; --i) {
+            assert(U3.insert(i));
+        }
+        assert(U3.insert(50) == false);
+        assert(U3.cardinality() == 100);
+        for (int i = 0; i < 100; ++i) {
+            assert(U3.is_member(i));
+        }
+        for (int i = 0; i < 100; i += 2) {
+            assert(U3.erase(i));
+        }
+        assert(U3.erase(0) == false);
+        assert(U3.cardinality() == 50 && U3.is_member(51));
+
+        U3 -= U3;
+        assert(U3.is_empty());
+
+        std::ostringstream os{};
+        os << U3 << ' ' << UnrolledSet{std::vector<int>{-1, 5, 7}};
+
+        std::string tmp{os.str()};
+        assert((tmp == std::string{"Set is empty! { -1 5 7 }"}));
+    }
+    assert(Set::get_count_nodes() == 0);
+
+
+    /*****************************************************
+     * TEST PHASE 15                                      *
+     * Cardinality-only queries                           *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 15: intersection_size, union_size, difference_size, jaccard, is_disjoint\n";
+
+    {
+        Set S1{std::vector<int>{1, 3, 5, 7, 9}};
+        Set S2{std::vector<int>{3, 4, 5, 6}};
+        Set S3{std::vector<int>{10, 20}};
+        Set S4{};
+        assert(Set::get_count_nodes() == 19);
+
+        // Test
+        assert(S1.intersection_size(S2) == 2);
+        assert(S1.union_size(S2) == 7);
+        assert(S1.difference_size(S2) == 3);
+        assert(S2.difference_size(S1) == 2);
+        assert(S1.jaccard(S2) == 2.0 / 7.0);
+        assert(S1.jaccard(S1) == 1.0);
+        assert(S4.jaccard(S4) == 1.0);
+        assert(S1.jaccard(S4) == 0.0);
+
+        assert(S1.is_disjoint(S2) == false);
+        assert(S1.is_disjoint(S3));
+        assert(S3.is_disjoint(S4));
+        assert(S1.is_disjoint(Set{std::vector<int>{0, 2, 4, 6, 8}}));
+
+        assert(Set::get_count_nodes() == 19);  // no nodes were allocated
+    }
+    assert(Set::get_count_nodes() == 0);
+
+
+    /*****************************************************
+     * TEST PHASE 16                                      *
+     * Batch membership queries                           *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 16: are_members\n";
+
+    {
+        std::vector<int> A1;
+        for (int i = 0; i < 1000; ++i) {
+            A1.push_back(3 * i);
+        }
+        Set S1{A1};
+
+        std::vector<int> Q1{-3, 0, 0, 4, 6, 2997, 3000};
+        std::vector<int> Q2{3000, 6, -3, 0, 4, 2997, 0};
+
+        // Test
+        assert((S1.are_members(Q1) == std::vector<bool>{false, true, true, false, true, true, false}));
+        assert((S1.are_members(Q2, Set::unsorted) == std::vector<bool>{false, true, false, true, false, true, true}));
+        assert(Set{}.are_members(Q1) == std::vector<bool>(Q1.size(), false));
+        assert(S1.are_members(std::vector<int>{}).empty());
+    }
+    assert(Set::get_count_nodes() == 0);
+
+
+    /*****************************************************
+     * TEST PHASE 17                                      *
+     * Bulk insert_range and erase_range, constructor     *
+     * from an unsorted vector                            *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 17: insert_range, erase_range\n";
+
+    {
+        Set S1{std::vector<int>{5, 1, 3, 3, 9, 1}};  // sorted and de-duplicated
+        assert(S1 == Set(std::vector<int>{1, 3, 5, 9}));
+        assert(Set::get_count_nodes() == 6);
+
+        // Test
+        std::vector<int> A1{0, 3, 4, 10};
+        assert(S1.insert_range(A1) == 3);
+        assert(Set::get_count_nodes() == 9);  // only new values get a node
+        assert(S1 == Set(std::vector<int>{0, 1, 3, 4, 5, 9, 10}));
+
+        std::vector<int> A2{10, 2, 2, 0};
+        assert(S1.insert_range(A2) == 1);
+        assert(S1.cardinality() == 8);
+
+        std::vector<int> A3{9, 0, 7, 1, 9};
+        assert(S1.erase_range(A3) == 3);
+        assert(S1 == Set(std::vector<int>{2, 3, 4, 5, 10}));
+        assert(S1.erase_range(std::vector<int>{}) == 0);
+        assert(S1.insert_range(std::vector<int>{4}) == 0);
+
+        std::vector<int> A4;
+        for (int i = 999; i >= 0; --i) {
+            A4.push_back(i);
+        }
+        assert(S1.insert_range(A4) == 995);
+        assert(S1.cardinality() == 1000 && S1.is_member(999));
+        assert(S1.erase_range(A4) == 1000);
+        assert(S1.is_empty());
+    }
+    assert(Set::get_count_nodes() == 0);
+
+
+    /*****************************************************
+     * TEST PHASE 18                                      *
+     * Hash of a Set, Sets as keys of unordered_map       *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 18: hash\n";
+
+    {
+        std::vector<int> A1;
+        std::vector<int> A2;
+        for (int i = 0; i < 100; ++i) {
+            A1.push_back(2 * i);
+            A2.push_back(2 * i + 1);
+        }
+
+        Set S1{A1};
+        Set S2{A2};
+        Set S3 = S1 + S2;  // 0..199
+
+        // Test
+        Set S4{};
+        for (int i = 199; i >= 0; --i) {
+            S4.insert(i);
+        }
+        assert(S3.hash() == S4.hash());
+        assert(S1.hash() != S2.hash());
+        assert(std::hash<Set>{}(S3) == S3.hash());
+
+        S4 -= S2;
+        assert(S4.hash() == S1.hash() && S4 == S1);
+        S4 *= S2;
+        assert(S4.hash() == Set{}.hash());
+
+        Set S5{S1};
+        S5 += Set{A2};  // nodes are moved from the operand
+        assert(S5.hash() == S3.hash());
+        assert((S1 <=> S2) == std::partial_ordering::unordered);
+
+        std::unordered_map<Set, int> M;
+        M[S1] = 1;
+        M[S2] = 2;
+        M[S3] = 3;
+        assert(M.size() == 3 && M[S5] == 3 && M[Set{A1}] == 1);
+    }
+    assert(Set::get_count_nodes() == 0);
+
+
+    /*****************************************************
+     * TEST PHASE 19                                      *
+     * SetPool: interning of Sets, memoized operations    *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 19: SetPool\n";
+
+    {
+        SetPool P{};
+        SetPool::Handle H1 = P.intern(Set{std::vector<int>{1, 3, 5}});
+        SetPool::Handle H2 = P.intern(Set{std::vector<int>{2, 3, 4}});
+        [[maybe_unused]] SetPool::Handle H3 = P.intern(Set{std::vector<int>{1, 3, 5}});
+
+        // Test
+        assert(H1 == H3 && H1 != H2);
+        assert(P.size() == 2);
+        assert(Set::get_count_nodes() == 10);  // duplicates are destroyed
+
+        [[maybe_unused]] SetPool::Handle U = P.unite(H1, H2);
+        assert(*U == Set(std::vector<int>{1, 2, 3, 4, 5}));
+        assert(P.unite(H2, H1) == U);
+        assert(P.size() == 3);
+
+        assert(P.intersect(H1, H2) == P.intern(Set{3}));
+        assert(P.subtract(H1, H2) == P.intern(Set{std::vector<int>{1, 5}}));
+        assert(P.subtract(H2, H1) != P.subtract(H1, H2));
+        assert(P.subtract(U, H2) == P.subtract(H1, H2));
+        assert(P.size() == 6);
+
+        std::unordered_map<SetPool::Handle, int> M;
+        M[H1] = 1;
+        assert(M[H3] == 1);
+        assert(H1->cardinality() == 3);
+    }
+    assert(Set::get_count_nodes() == 0);
+
+    {
+        SetPool::Handle H;  // outlives its pool
+        assert(!H);
+        {
+            SetPool P{2};  // memo tables of at most 2 results
+            SetPool::Handle H1 = P.intern(Set{1});
+            SetPool::Handle H2 = P.intern(Set{2});
+            SetPool::Handle H3 = P.intern(Set{3});
+            P.unite(H1, H2);
+            P.unite(H1, H3);
+            assert(P.memo_size() == 2);
+            H = P.unite(H2, H3);  // clears the unions first
+            assert(P.memo_size() == 1);
+            assert(P.unite(H3, H2) == H);
+            assert(P.unite(P.unite(H1, H2), H3) == P.intern(Set{std::vector<int>{1, 2, 3}}));
+        }
+        assert(H && *H == Set(std::vector<int>{2, 3}));
+    }
+    assert(Set::get_count_nodes() == 0);
+
+
+    /*****************************************************
+     * TEST PHASE 20                                      *
+     * Copy-on-write: copies of large Sets share nodes    *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 20: copy-on-write\n";
+
+    {
+        std::vector<int> A1;
+        for (int i = 0; i < 100; ++i) {
+            A1.push_back(i);
+        }
+
+        const Set S1{A1};
+        assert(Set::get_count_nodes() == 104);
+
+        // Test
+        Set S2{S1};
+        Set S3{S2};
+        Set S4{};
+        S4 = S1;
+        assert(Set::get_count_nodes() == 110);  // only the dummy nodes of the copies were created
+        assert(S2 == S1 && S4 == S1 && S3.is_member(99));
+
+        S2 += 100;  // the list is copied on the first modification
+        assert(Set::get_count_nodes() == 213);
+        assert(S2.cardinality() == 101 && S1.cardinality() == 100);
+
+        S3.make_empty();  // no copy is needed
+        assert(Set::get_count_nodes() == 213);
+
+        S4 -= Set{std::vector<int>{0, 1}};
+        assert(Set::get_count_nodes() == 313);
+        assert(S4.cardinality() == 98 && S1.is_member(0));
+
+        Set S5{S1};
+        Set S6{std::move(S5)};
+        assert(S5.is_empty() && S6 == S1);
+        assert(Set::get_count_nodes() == 317);
+
+        Set S7{S6};
+        S7 *= S6;
+        assert(S7 == S1);
+        assert(Set::get_count_nodes() == 421);
+
+        Set S8{std::vector<int>{1, 2, 3}};  // small Sets are copied
+        Set S9{S8};
+        assert(Set::get_count_nodes() == 431);
+    }
+    assert(Set::get_count_nodes() == 0);
+
+
+    /*****************************************************
+     * TEST PHASE 21                                      *
+     * Order statistics: rank, select, range              *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 21: rank, select, range\n";
+
+    {
+        std::vector<int> A1;
+        for (int i = 0; i < 1000; ++i) {
+            A1.push_back(10 * i);
+        }
+        Set S1{A1};                                  // indexed
+        Set S2{std::vector<int>{-5, 0, 7, 20}};      // not indexed
+
+        // Test
+        assert(S1.rank(0) == 0 && S1.rank(1) == 1 && S1.rank(5000) == 500 && S1.rank(100000) == 1000);
+        assert(S1.select(0) == 0 && S1.select(123) == 1230 && S1.select(999) == 9990);
+        assert((S1.range(95, 131) == std::vector<int>{100, 110, 120, 130}));
+        assert(S1.range(10, 10).empty());
+
+        assert(S2.rank(7) == 2 && S2.select(3) == 20);
+        assert((S2.range(-100, 8) == std::vector<int>{-5, 0, 7}));
+
+        // the counts of the index are updated by insert and erase
+        for (int i = 0; i < 1000; i += 2) {
+            S1.insert(10 * i + 5);
+        }
+        S1.erase(0);
+        assert(S1.cardinality() == 1499);
+        assert(S1.rank(25) == 3 && S1.select(3) == 25 && S1.select(0) == 5);
+        assert(S1.select(1498) == 9990 && S1.rank(9990) == 1498);
+        for (size_t k = 0; k < S1.cardinality(); k += 37) {
+            assert(S1.rank(S1.select(k)) == k);
+        }
+    }
+    assert(Set::get_count_nodes() == 0);
+
+
+    /*****************************************************
+     * TEST PHASE 22                                      *
+     * Iterators, std::ranges algorithms and views        *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 22: iterators\n";
+
+    {
+        static_assert(std::ranges::bidirectional_range<Set>);
+
+        Set S1{std::vector<int>{1, 3, 5, 8}};
+        const Set S2{};
+
+        // Test
+        std::vector<int> V;
+        V.reserve(S1.cardinality());
+        std::ranges::copy(S1, std::back_inserter(V));
+        assert((V == std::vector<int>{1, 3, 5, 8}));
+
+        assert(S2.begin() == S2.end());
+        assert(*std::prev(S1.end()) == 8);
+        assert(std::accumulate(S1.begin(), S1.end(), 0) == 17);
+        assert(std::ranges::distance(S1) == 4);
+        assert(*std::ranges::lower_bound(S1, 4) == 5);
+
+        std::vector<int> R;
+        for (int x : S1 | std::views::reverse | std::views::filter([](int x) { return x % 2 != 0; })) {
+            R.push_back(x);
+        }
+        assert((R == std::vector<int>{5, 3, 1}));
+
+        std::vector<int> A1;
+        for (int i = 0; i < 100; ++i) {
+            A1.push_back(i);
+        }
+        Set S3{A1};
+        Set S4{S3};  // shared list
+        assert(std::ranges::equal(S3, S4) && std::ranges::equal(S4, A1));
+
+        Set S5{std::vector<int>(A1.begin(), A1.begin() + 20)};
+        [[maybe_unused]] auto last = S5.end();
+        int sum = 0;
+        for (int x : S5) {
+            if (x == 3) Set{S5};  // copying does not invalidate the iterators of S5
+            sum += x;
+        }
+        assert(sum == 190 && last == S5.end());
+    }
+    assert(Set::get_count_nodes() == 0);
+
+    /*****************************************************
+     * TEST PHASE 23                                      *
+     * Sets of other types, comparators, and allocators   *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 23: BasicSet<T, Compare, Allocator>\n";
+
+    {
+        using StringSet = BasicSet<std::string>;
+
+        StringSet S1{std::vector<std::string>{"pear", "apple", "fig"}};
+        StringSet S2 = S1 + "kiwi" - "pear";
+
+        // Test
+        std::ostringstream os{};
+        os << S2;
+        assert(os.str() == "{ apple fig kiwi }");
+        assert(S1.is_member("fig") && !S2.is_member("pear"));
+        assert(S1.select(1) == "fig" && S2.rank("grape") == 2);
+        assert(S1 * S2 == StringSet(std::vector<std::string>{"apple", "fig"}));
+
+        // Decreasing order
+        BasicSet<long, std::greater<long>> S3{std::vector<long>{1, 10'000'000'000, 5}};
+        BasicSet<long, std::greater<long>> S4 = S3 - 5L;
+
+        // Test
+        assert(S3.select(0) == 10'000'000'000 && S3.select(2) == 1);
+        assert((S4 == BasicSet<long, std::greater<long>>{std::vector<long>{10'000'000'000, 1}}));
+        assert(S4 < S3);
+
+        // Nodes of temporary Sets allocated from one buffer, released at once
+        std::pmr::monotonic_buffer_resource buffer;
+        std::pmr::polymorphic_allocator<int> alloc{&buffer};
+
+        pmr::Set<int> S5{alloc};
+        pmr::Set<int> S6{alloc};
+        for (int i = 0; i < 100; ++i) {
+            S5.insert(i);
+            S6.insert(2 * i);
+        }
+        pmr::Set<int> S7 = S5 * S6;
+        pmr::Set<int> S8 = S7;  // default memory resource
+
+        // Test
+        assert(S7.cardinality() == 50 && S8 == S7);
+        assert(S7.get_allocator() == alloc && S8.get_allocator().resource() == std::pmr::get_default_resource());
+        S8 += std::move(S7);
+        assert(S8.cardinality() == 50);
+    }
+    assert(Set::get_count_nodes() == 0);
+    assert(pmr::Set<int>::get_count_nodes() == 0);
+
+    /*****************************************************
+     * TEST PHASE 24                                      *
+     * ConcurrentSet shared by several threads            *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 24: ConcurrentSet\n";
+
+    {
+        ConcurrentSet S1{std::vector<int>{1, 3, 5}};
+
+        // Test
+        assert(S1.insert(4) && !S1.insert(4));
+        assert(S1.erase(1) && !S1.erase(1));
+        assert(S1.is_member(4) && !S1.is_member(1));
+        assert((S1.snapshot() == std::vector<int>{3, 4, 5}));
+
+        std::ostringstream os{};
+        os << S1;
+        assert(os.str() == "{ 3 4 5 }");
+
+        // Each thread inserts the multiples of 4 plus its number, then erases half of them
+        ConcurrentSet S2;
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([&S2, t] {
+                for (int i = 0; i < 1000; ++i) {
+                    S2.insert(4 * i + t);
+                }
+                for (int i = 0; i < 1000; i += 2) {
+                    S2.erase(4 * i + t);
+                }
+            });
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+
+        // Test
+        assert(S2.cardinality() == 2000);
+        assert(S2.is_member(4 * 1 + 3) && !S2.is_member(4 * 2 + 3));
+
+        Set S3{S2.snapshot()};
+        assert(S3.cardinality() == 2000 && S3.select(0) == 4 && S3.select(1999) == 4 * 999 + 3);
+        assert((S1 + S2).size() == 2001);
+        assert((S1 * S2 == std::vector<int>{4, 5}));
+        assert((S1 - S2 == std::vector<int>{3}));
+    }
+    assert(Set::get_count_nodes() == 0);
+
+    /*****************************************************
+     * TEST PHASE 25                                      *
+     * Union and intersection of many Sets                *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 25: union_all and intersect_all\n";
+
+    {
+        ThreadPool pool{3};
+
+        // Multiples of 2, 3, ..., 7 smaller than 420
+        std::vector<Set> multiples;
+        for (int m = 2; m <= 7; ++m) {
+            std::vector<int> v;
+            for (int x = 0; x < 420; x += m) {
+                v.push_back(x);
+            }
+            multiples.push_back(Set{v});
+        }
+        std::vector<const Set*> sets;
+        for (const Set& S : multiples) {
+            sets.push_back(&S);
+        }
+
+        // Test
+        Set S1 = Set::union_all(sets, pool);
+        Set S2 = Set::intersect_all(sets, pool);
+        assert(S1.cardinality() == 420 - 96);  // 96 values in [0, 420) are coprime to 2, 3, 5, 7
+        assert(!S1.is_member(1) && S1.is_member(49) && !S1.is_member(419));
+        assert(S2 == Set(std::vector<int>{0}));
+
+        Set S3;
+        sets.push_back(&S3);
+        assert(Set::intersect_all(sets, pool).is_empty());
+        assert(Set::union_all(sets, pool) == S1);
+        assert(Set::union_all(std::span<const Set*>{}, pool).is_empty());
+        assert(Set::union_all(sets) == S1 && Set::intersect_all(sets).is_empty());  // on ThreadPool::shared()
+    }
+    assert(Set::get_count_nodes() == 0);
+
+    /*****************************************************
+     * TEST PHASE 26                                      *
+     * FlatSet operations split between threads           *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 26: FlatSet parallel operations\n";
+
+    {
+        ThreadPool pool{3};
+
+        // Multiples of 2 and of 3, large enough to be split
+        std::vector<int> A1, A2;
+        for (int x = 0; x < 300000; ++x) {
+            if (x % 2 == 0) A1.push_back(x);
+            if (x % 3 == 0) A2.push_back(x);
+        }
+        const FlatSet S1{A1};
+        const FlatSet S2{A2};
+
+        FlatSet S3{S1};
+        FlatSet S4{S1};
+        FlatSet S5{S1};
+        S3.parallel_union(S2, pool);
+        S4.parallel_intersection(S2, pool);
+        S5.parallel_difference(S2, pool);
+
+        // Test
+        assert(S3 == S1 + S2 && S3.cardinality() == 200000);
+        assert(S4 == S1 * S2 && S4.cardinality() == 50000);
+        assert(S5 == S1 - S2 && S5.cardinality() == 100000);
+
+        FlatSet S6{S2};
+        S6.parallel_intersection(S6, pool);
+        assert(S6 == S2);
+        S6.parallel_union(FlatSet{7}, pool);  // skewed sizes: sequential
+        assert(S6.cardinality() == S2.cardinality() + 1);
+        S6.parallel_difference(S2);  // on ThreadPool::shared()
+        assert(S6 == FlatSet{7});
+    }
+
+    /*****************************************************
+     * TEST PHASE 27                                      *
+     * FlatSet SIMD kernels                               *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 27: FlatSet kernels\n";
+
+    {
+        // Multiples of 2 and of 3, with a block of negative values
+        std::vector<int> A1, A2;
+        for (int x = -40; x < 1000; ++x) {
+            if (x % 2 == 0) A1.push_back(x);
+            if (x % 3 == 0 || x < -20) A2.push_back(x);
+        }
+        std::vector<int> A3{-39, -38, 0, 1, 1, 998, 999, 5000};
+
+        // Every instruction set supported here gives the same results as the scalar kernels
+        const flat_simd::Kernels& scalar = flat_simd::kernels(flat_simd::Isa::scalar);
+        for (auto isa : {flat_simd::Isa::scalar, flat_simd::Isa::sse42, flat_simd::Isa::avx2}) {
+            if (!flat_simd::supported(isa)) continue;
+            const flat_simd::Kernels& K = flat_simd::kernels(isa);
+
+            for (auto kernel : {&flat_simd::Kernels::intersect, &flat_simd::Kernels::difference,
+                                &flat_simd::Kernels::unite}) {
+                std::vector<int> R1(A1.size() + A2.size());
+                std::vector<int> R2(A1.size() + A2.size());
+                R1.resize((K.*kernel)(A1.data(), A1.size(), A2.data(), A2.size(), R1.data()));
+                R2.resize((scalar.*kernel)(A1.data(), A1.size(), A2.data(), A2.size(), R2.data()));
+                assert(R1 == R2);
+            }
+
+            std::vector<unsigned char> found(A3.size());
+            K.are_members(A1.data(), A1.size(), A3.data(), A3.size(), found.data());
+            assert((found == std::vector<unsigned char>{0, 1, 1, 0, 0, 1, 0, 0}));
+        }
+
+        const FlatSet S1{A1};
+        const FlatSet S2{A2};
+
+        // Test
+        assert((S1 * S2).cardinality() == 10 + 170);  // -40, -38, ..., -22 and the multiples of 6 in [-20, 1000)
+        assert((S1 + S2).cardinality() == 520 + 360 - 180);
+        assert((S1 - S2).cardinality() == 520 - 180);
+        assert((S1.are_members(A3) == std::vector<bool>{false, true, true, false, false, true, false, false}));
+    }
+
+    /*****************************************************
+     * TEST PHASE 28                                      *
+     * Binary Set files                                   *
+     ******************************************************/
+    std::cout << "\nTEST PHASE 28: Set files\n";
+
+    {
+        std::vector<int> A1;
+        for (int x = -1000; x < 100000; x += 7) {
+            A1.push_back(x);
+        }
+        const Set S1{A1};
+        const std::string path = (std::filesystem::temp_directory_path() / "lab2_set_file.bin").string();
+
+        for (auto encoding : {set_file::Encoding::raw, set_file::Encoding::delta}) {
+            set_file::write(path, S1, encoding);
+            set_file::MappedSet M{path};
+
+            // Test
+            assert(M.encoding() == encoding && M.cardinality() == S1.cardinality());
+            assert(M.is_member(-1000) && M.is_member(99996) && !M.is_member(0));
+            assert(M.to_set() == S1);
+            assert(M.to_vector() == A1);
+            assert(encoding != set_file::Encoding::raw || M.values()[1] == -993);
+        }
+        assert(std::filesystem::file_size(path) < 4 * A1.size());  // deltas of 7 take 1 byte
+
+        set_file::write(path, std::span<const int>{});
+        assert(set_file::read(path).is_empty());
+
+        {
+            std::ofstream os{path};
+            os << S1;  // text, not binary
+        }
+        [[maybe_unused]] bool rejected = false;
+        try {
+            set_file::MappedSet M{path};
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        assert(rejected);
+
+        {
+            // Delta file with a count of 2^40 values in a 2-byte payload
+            auto le = [](std::uint64_t x, int bytes) {
+                std::string s;
+                for (int i = 0; i < bytes; ++i) s += static_cast<char>(x >> (8 * i) & 0xFF);
+                return s;
+            };
+            std::ofstream os{path, std::ios::binary};
+            os << std::string{"LAB2SET", 8} << le(set_file::version, 4) << le(1, 4) << le(std::uint64_t{1} << 40, 8)
+               << le(2, 8) << std::string(2, '\0');
+        }
+        rejected = false;
+        try {
+            set_file::MappedSet M{path};
+        } catch (const std::runtime_error&) {
+            rejected = true;
+        }
+        assert(rejected);
+        std::filesystem::remove(path);
+    }
+    assert(Set::get_count_nodes() == 0);
+
     std::cout << "Success!!!\n";
 }
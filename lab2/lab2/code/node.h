@@ -1,23 +1,29 @@
 #pragma once
 
 #include <cassert>
+#include <cstddef>
+#include <new>
 
-/** Class Set::Node
+#include "set.h"
+#include "nodepool.h"
+
+/** Class BasicSet::Node
  *
- * This class represents an internal node of a doubly linked list storing an int
- * All members of class Set::Node are public
- * but only class Set can access them, since Node is declared in the private part of class Set
+ * This class represents an internal node of a doubly linked list storing a value of type T
+ * All members of class BasicSet::Node are public
+ * but only class BasicSet can access them, since Node is declared in the private part of class BasicSet
  *
  */
-class Set::Node {
+template <class T, class Compare, class Allocator>
+class BasicSet<T, Compare, Allocator>::Node {
 public:
     /*
      * Constructor
-     * \param nodeVal int to be stored in the Node
+     * \param nodeVal value to be stored in the Node
      * \param nextPtr a pointer to the next Node in the list
      * \param prevPtr a pointer to the previous Node in the list
      */
-    explicit Node(int nodeVal = 0, Node* nextPtr = nullptr, Node* prevPtr = nullptr)
+    explicit Node(const T& nodeVal = T{}, Node* nextPtr = nullptr, Node* prevPtr = nullptr)
         : value{nodeVal}, next{nextPtr}, prev{prevPtr} {
         ++count_nodes;
     }
@@ -40,10 +46,21 @@ public:
      */
     Node& operator=(const Node& rhs) = delete;
 
+    /*
+     * With the default allocator, Nodes are allocated from a NodePool shared by all Sets
+     * (see BasicSet::allocate_node), instead of one call to the global operator new per Node.
+     * The pool is created on first use and never destroyed: a static Set may be constructed
+     * before it (the dummy nodes are stored in the Set) and free its Nodes after it.
+     */
+    static NodePool& pool() {
+        static NodePool& the_pool = *new NodePool{sizeof(Node), alignof(Node)};
+        return the_pool;
+    }
+
     // Data members
-    int value;   // int stored in the Node
+    T value;     // value stored in the Node
     Node* next;  // Pointer to the next Node
     Node* prev;  // Pointer to the previous Node
 
-    static int count_nodes;  // total number of existing nodes -- to help to detect bugs in the code
+    inline static int count_nodes = 0;  // total number of existing nodes -- to help to detect bugs in the code
 };
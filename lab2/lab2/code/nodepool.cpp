@@ -0,0 +1,65 @@
+#include "nodepool.h"
+#include <new>
+#include <algorithm>
+
+/*
+ * Blocks must be able to hold a FreeBlock, and their size is rounded up to a
+ * multiple of the alignment so that consecutive blocks in a slab stay aligned.
+ */
+NodePool::NodePool(std::size_t size_of_block, std::size_t alignment)
+    : size_of_block{round_up(std::max(size_of_block, sizeof(FreeBlock)),
+                             std::max(alignment, alignof(FreeBlock)))},
+      alignment{std::max(alignment, alignof(FreeBlock))},
+      total_blocks{0},
+      next_slab_blocks{first_slab_blocks},
+      free_list{nullptr},
+      bump{nullptr},
+      bump_end{nullptr} {
+}
+
+NodePool::~NodePool() {
+    for (std::byte* slab : slabs) {
+        ::operator delete(slab, std::align_val_t{alignment});
+    }
+}
+
+/*
+ * Reuse the most recently released block, if any.
+ * Otherwise, carve the next block out of the current slab.
+ */
+void* NodePool::allocate() {
+    if (free_list != nullptr) {
+        FreeBlock* block = free_list;
+        free_list = block->next;
+        return block;
+    }
+    if (bump == bump_end) {
+        add_slab();
+    }
+    void* block = bump;
+    bump += size_of_block;
+    return block;
+}
+
+void NodePool::deallocate(void* p) noexcept {
+    if (p == nullptr) return;
+    FreeBlock* block = static_cast<FreeBlock*>(p);
+    block->next = free_list;
+    free_list = block;
+}
+
+/*
+ * Slabs grow geometrically, so that small programs do not reserve much memory
+ * while large Sets need few slabs.
+ */
+void NodePool::add_slab() {
+    std::size_t bytes = next_slab_blocks * size_of_block;
+    slabs.reserve(slabs.size() + 1);  // make sure push_back below does not throw
+    std::byte* slab = static_cast<std::byte*>(::operator new(bytes, std::align_val_t{alignment}));
+    slabs.push_back(slab);
+
+    bump = slab;
+    bump_end = slab + bytes;
+    total_blocks += next_slab_blocks;
+    next_slab_blocks = std::min(2 * next_slab_blocks, max_slab_blocks);
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+/** Class NodePool
+ *
+ * Slab allocator for fixed-size blocks, used to allocate the Nodes of a Set, the entries of
+ * its index, and the Blocks of an UnrolledSet.
+ * Blocks are carved out of large slabs (so consecutive allocations are packed next to each other)
+ * and released blocks are kept in a freelist to be reused by later allocations.
+ * Slabs are only returned to the system when the pool is destroyed.
+ * Each pool is given the alignment of its blocks: a Set Node then takes 24 bytes, rather than
+ * 32 with alignof(std::max_align_t), and an UnrolledSet Block fills one cache line.
+ *
+ * A NodePool is not thread-safe.
+ */
+class NodePool {
+public:
+    /*
+     * Constructor
+     * \param size_of_block number of bytes of each block handed out by allocate()
+     * \param alignment of the blocks, a power of two
+     */
+    NodePool(std::size_t size_of_block, std::size_t alignment);
+
+    /*
+     * Destructor: return all slabs to the system.
+     */
+    ~NodePool();
+
+    /*
+     * Copy constructor and assignment operator -- disallowed, a pool owns its slabs
+     */
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    /*
+     * Return a pointer to an uninitialized block of block_size() bytes.
+     * Blocks released with deallocate() are reused first.
+     */
+    void* allocate();
+
+    /*
+     * Give back a block previously returned by allocate().
+     */
+    void deallocate(void* p) noexcept;
+
+    /*
+     * Number of bytes of each block.
+     */
+    std::size_t block_size() const {
+        return size_of_block;
+    }
+
+    /*
+     * Total number of blocks owned by the pool (in use or free).
+     */
+    std::size_t capacity() const {
+        return total_blocks;
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    static constexpr std::size_t first_slab_blocks = 64;
+    static constexpr std::size_t max_slab_blocks = 64 * 1024;
+
+    std::size_t size_of_block;
+    std::size_t alignment;
+    std::size_t total_blocks;           // Number of blocks in all slabs
+    std::size_t next_slab_blocks;       // Number of blocks in the next slab to be allocated
+    FreeBlock* free_list;               // Released blocks, most recently released first
+    std::byte* bump;                    // First never used byte in the current slab
+    std::byte* bump_end;                // End of the current slab
+    std::vector<std::byte*> slabs;
+
+    void add_slab();
+
+    static std::size_t round_up(std::size_t n, std::size_t multiple) {
+        return (n + multiple - 1) / multiple * multiple;
+    }
+};
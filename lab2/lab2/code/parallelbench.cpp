@@ -0,0 +1,169 @@
+/*
+ * Scaling of Set::union_all and Set::intersect_all, and of the FlatSet parallel operations,
+ * with the number of threads.
+ *
+ * k random Sets of n values each, drawn from [0, 4kn), are combined with a ThreadPool of
+ * 1, 2, 4, ..., max-threads workers, and with a sequential fold of operator+= (resp. operator*=)
+ * as the baseline. For the intersection, the first k / 2 Sets also hold every fourth value
+ * of [0, 4n), so that the result is not empty.
+ * Then two FlatSets of m values each, drawn from [0, 4m), are combined by parallel_union and
+ * parallel_intersection, against operator+= and operator*=.
+ * Results (best of a few runs, in milliseconds) are written to stdout as JSON.
+ *
+ * Usage: ParallelBench [--max-threads t] [--sets k] [--size n] [--flat-size m]     (build in Release mode)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "set.h"
+#include "flatset.h"
+#include "threadpool.h"
+
+namespace {
+
+constexpr int repetitions = 5;
+
+size_t sink = 0;  // cardinalities are added here, so that work is not optimized away
+
+struct Result {
+    std::string operation;
+    std::string method;
+    int threads;
+    double ms;
+};
+
+/*
+ * Best time of f over the repetitions, in milliseconds.
+ */
+template <class F>
+double best_ms(F f) {
+    double best = 1e300;
+    for (int r = 0; r < repetitions; ++r) {
+        auto start = std::chrono::steady_clock::now();
+        sink += f();
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        best = std::min(best, elapsed.count());
+    }
+    return best;
+}
+
+std::vector<Set> random_sets(int k, int n, bool overlapping) {
+    std::mt19937 rng{42};
+    std::uniform_int_distribution<int> value(0, 4 * k * n - 1);
+    std::vector<int> common;
+    for (int x = 0; x < 4 * n; x += 4) {
+        common.push_back(x);
+    }
+
+    std::vector<Set> sets;
+    for (int i = 0; i < k; ++i) {
+        std::vector<int> v;
+        if (overlapping && i < k / 2) v = common;
+        for (int j = 0; j < n; ++j) v.push_back(value(rng));
+        sets.push_back(Set{v});
+    }
+    return sets;
+}
+
+FlatSet random_flat_set(int m, unsigned seed) {
+    std::mt19937 rng{seed};
+    std::uniform_int_distribution<int> value(0, 4 * m - 1);
+    std::vector<int> v;
+    for (int j = 0; j < m; ++j) v.push_back(value(rng));
+    std::sort(v.begin(), v.end());
+    v.erase(std::unique(v.begin(), v.end()), v.end());
+    return FlatSet{v};
+}
+
+void write_json(std::ostream& os, const std::vector<Result>& results, int k, int n, int m) {
+    os << "{\n  \"sets\": " << k << ",\n  \"size\": " << n << ",\n  \"flat_size\": " << m
+       << ",\n  \"hardware_threads\": "
+       << std::thread::hardware_concurrency() << ",\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        os << "    {\"operation\": \"" << r.operation << "\", \"method\": \"" << r.method << "\", \"threads\": "
+           << r.threads << ", \"ms\": " << r.ms << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ]\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int max_threads = 32;
+    int k = 64;
+    int n = 100000;
+    int m = 10000000;
+    for (int i = 1; i < argc; i += 2) {
+        std::string option{argv[i]};
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (value != nullptr && option == "--max-threads") {
+            max_threads = std::atoi(value);
+        } else if (value != nullptr && option == "--sets") {
+            k = std::atoi(value);
+        } else if (value != nullptr && option == "--size") {
+            n = std::atoi(value);
+        } else if (value != nullptr && option == "--flat-size") {
+            m = std::atoi(value);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--max-threads t] [--sets k] [--size n] [--flat-size m]\n";
+            return 2;
+        }
+    }
+
+    std::vector<Result> results;
+    for (std::string operation : {"union", "intersection"}) {
+        bool is_union = operation == "union";
+        std::vector<Set> sets = random_sets(k, n, !is_union);
+        std::vector<const Set*> pointers;
+        for (const Set& S : sets) pointers.push_back(&S);
+
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            ThreadPool pool{static_cast<unsigned>(threads)};
+            results.push_back({operation, is_union ? "union_all" : "intersect_all", threads, best_ms([&] {
+                                   Set R = is_union ? Set::union_all(pointers, pool) : Set::intersect_all(pointers, pool);
+                                   return R.cardinality();
+                               })});
+        }
+
+        // Last, since the intermediate results of the fold scatter the free Nodes of the NodePool,
+        // which slows down the lists built after it
+        results.push_back({operation, "sequential fold", 1, best_ms([&] {
+                               Set R = sets[0];
+                               for (size_t i = 1; i < sets.size(); ++i) {
+                                   if (is_union)
+                                       R += sets[i];
+                                   else
+                                       R *= sets[i];
+                               }
+                               return R.cardinality();
+                           })});
+    }
+
+    const FlatSet F1 = random_flat_set(m, 1);
+    const FlatSet F2 = random_flat_set(m, 2);
+    for (std::string operation : {"flat union", "flat intersection"}) {
+        bool is_union = operation == "flat union";
+        results.push_back({operation, "sequential", 1, best_ms([&] {
+                               FlatSet R{F1};
+                               return (is_union ? (R += F2) : (R *= F2)).cardinality();
+                           })});
+        for (int threads = 1; threads <= max_threads; threads *= 2) {
+            ThreadPool pool{static_cast<unsigned>(threads)};
+            results.push_back({operation, "merge path", threads, best_ms([&] {
+                                   FlatSet R{F1};
+                                   return (is_union ? R.parallel_union(F2, pool) : R.parallel_intersection(F2, pool))
+                                       .cardinality();
+                               })});
+        }
+    }
+
+    write_json(std::cout, results, k, n, m);
+}
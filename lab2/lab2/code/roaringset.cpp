@@ -0,0 +1,500 @@
+#include "roaringset.h"
+#include <algorithm>
+#include <bit>
+#include <iterator>
+
+namespace roaring {
+
+namespace {
+
+/*
+ * Free the memory of v (v = {} would keep its capacity).
+ */
+template <class T>
+void release(std::vector<T>& v) {
+    std::vector<T>{}.swap(v);
+}
+
+}  // namespace
+
+/*****************************************************
+ * Implementation of roaring::Container               *
+ ******************************************************/
+
+bool Container::contains(std::uint16_t low) const {
+    switch (kind) {
+        case Kind::Array:
+            return std::binary_search(array.begin(), array.end(), low);
+        case Kind::Bitmap:
+            return (bitmap[low / 64] >> (low % 64)) & 1;
+        case Kind::Run: {
+            // last run starting at or before low
+            auto it = std::upper_bound(runs.begin(), runs.end(), low,
+                                       [](std::uint16_t v, const Run& r) { return v < r.start; });
+            if (it == runs.begin()) return false;
+            --it;
+            return low - it->start <= it->length;
+        }
+    }
+    return false;
+}
+
+template <class F>
+void Container::for_each(F f) const {
+    switch (kind) {
+        case Kind::Array:
+            for (std::uint16_t low : array) f(low);
+            break;
+        case Kind::Bitmap:
+            for (std::size_t i = 0; i < bitmap_words; ++i) {
+                for (std::uint64_t w = bitmap[i]; w != 0; w &= w - 1) {
+                    f(static_cast<std::uint16_t>(i * 64 + std::countr_zero(w)));
+                }
+            }
+            break;
+        case Kind::Run:
+            for (const Run& r : runs) {
+                for (std::uint32_t v = r.start; v <= std::uint32_t{r.start} + r.length; ++v) {
+                    f(static_cast<std::uint16_t>(v));
+                }
+            }
+            break;
+    }
+}
+
+void Container::to_bitmap() {
+    if (kind == Kind::Bitmap) return;
+
+    std::vector<std::uint64_t> words(bitmap_words, 0);
+    if (kind == Kind::Run) {
+        for (const Run& r : runs) {
+            // set bits [start, start + length], word by word
+            std::uint32_t first = r.start;
+            std::uint32_t last = first + r.length;
+            while (first <= last) {
+                std::uint32_t word_end = std::min(last, first | 63);
+                std::uint32_t n = word_end - first + 1;
+                std::uint64_t mask = (n == 64) ? ~std::uint64_t{0} : ((std::uint64_t{1} << n) - 1);
+                words[first / 64] |= mask << (first % 64);
+                first = word_end + 1;
+            }
+        }
+    } else {
+        for_each([&words](std::uint16_t low) { words[low / 64] |= std::uint64_t{1} << (low % 64); });
+    }
+    bitmap.swap(words);
+    release(array);
+    release(runs);
+    kind = Kind::Bitmap;
+}
+
+void Container::to_array() {
+    if (kind == Kind::Array) return;
+
+    std::vector<std::uint16_t> values;
+    values.reserve(card);
+    for_each([&values](std::uint16_t low) { values.push_back(low); });
+    array.swap(values);
+    release(bitmap);
+    release(runs);
+    kind = Kind::Array;
+}
+
+void Container::expand_runs() {
+    if (kind != Kind::Run) return;
+    if (card > array_max)
+        to_bitmap();
+    else
+        to_array();
+}
+
+void Container::optimize() {
+    // Count the runs in the values
+    std::size_t n_runs = 0;
+    std::int32_t previous = -2;
+    for_each([&](std::uint16_t low) {
+        if (low != previous + 1) ++n_runs;
+        previous = low;
+    });
+
+    std::size_t run_bytes = n_runs * sizeof(Run);
+    std::size_t array_bytes = card * sizeof(std::uint16_t);
+    std::size_t bitmap_bytes = bitmap_words * sizeof(std::uint64_t);
+
+    if (run_bytes < std::min(array_bytes, bitmap_bytes)) {
+        if (kind == Kind::Run) return;
+        std::vector<Run> new_runs;
+        new_runs.reserve(n_runs);
+        for_each([&new_runs](std::uint16_t low) {
+            if (!new_runs.empty() && new_runs.back().start + new_runs.back().length + 1 == low)
+                ++new_runs.back().length;
+            else
+                new_runs.push_back(Run{low, 0});
+        });
+        runs.swap(new_runs);
+        release(array);
+        release(bitmap);
+        kind = Kind::Run;
+    } else if (array_bytes <= bitmap_bytes) {
+        to_array();
+    } else {
+        to_bitmap();
+    }
+}
+
+std::size_t Container::bytes() const {
+    return sizeof(Container) + array.capacity() * sizeof(std::uint16_t) +
+           bitmap.capacity() * sizeof(std::uint64_t) + runs.capacity() * sizeof(Run);
+}
+
+namespace {
+
+/*
+ * After a bitmap operation: recount the values with popcount and
+ * use an array if the container became small.
+ */
+void recount_bitmap(Container& c) {
+    std::uint32_t n = 0;
+    for (std::uint64_t w : c.bitmap) n += std::popcount(w);
+    c.card = n;
+    if (c.card <= Container::array_max) c.to_array();
+}
+
+/*
+ * Return c, or a copy of c expanded into tmp if c is a run container.
+ */
+const Container& expanded(const Container& c, Container& tmp) {
+    if (c.kind != Container::Kind::Run) return c;
+    tmp = c;
+    tmp.expand_runs();
+    return tmp;
+}
+
+/*
+ * Set algebra on two containers with the same key.
+ * Run containers are expanded first; if both operands were runs,
+ * the result is optimized again, to keep ranges compressed.
+ */
+void unite(Container& a, const Container& b_in) {
+    bool runs = (a.kind == Container::Kind::Run && b_in.kind == Container::Kind::Run);
+    Container tmp;
+    const Container& b = expanded(b_in, tmp);
+    a.expand_runs();
+
+    if (a.kind == Container::Kind::Array && b.kind == Container::Kind::Array) {
+        std::vector<std::uint16_t> result;
+        result.reserve(a.array.size() + b.array.size());
+        std::set_union(a.array.begin(), a.array.end(), b.array.begin(), b.array.end(),
+                       std::back_inserter(result));
+        a.array.swap(result);
+        a.card = static_cast<std::uint32_t>(a.array.size());
+        if (a.card > Container::array_max) a.to_bitmap();
+    } else {
+        a.to_bitmap();
+        if (b.kind == Container::Kind::Bitmap) {
+            for (std::size_t i = 0; i < Container::bitmap_words; ++i) a.bitmap[i] |= b.bitmap[i];
+        } else {
+            for (std::uint16_t low : b.array) a.bitmap[low / 64] |= std::uint64_t{1} << (low % 64);
+        }
+        recount_bitmap(a);
+    }
+    if (runs) a.optimize();
+}
+
+void intersect(Container& a, const Container& b_in) {
+    bool runs = (a.kind == Container::Kind::Run && b_in.kind == Container::Kind::Run);
+    Container tmp;
+    const Container& b = expanded(b_in, tmp);
+    a.expand_runs();
+
+    if (a.kind == Container::Kind::Bitmap && b.kind == Container::Kind::Bitmap) {
+        for (std::size_t i = 0; i < Container::bitmap_words; ++i) a.bitmap[i] &= b.bitmap[i];
+        recount_bitmap(a);
+    } else {
+        if (a.kind == Container::Kind::Bitmap) {
+            // keep the values of array b found in a
+            std::vector<std::uint16_t> values;
+            std::copy_if(b.array.begin(), b.array.end(), std::back_inserter(values),
+                         [&a](std::uint16_t low) { return a.contains(low); });
+            a.array.swap(values);
+            release(a.bitmap);
+            a.kind = Container::Kind::Array;
+        } else {
+            // keep the values of array a found in b
+            std::erase_if(a.array, [&b](std::uint16_t low) { return !b.contains(low); });
+        }
+        a.card = static_cast<std::uint32_t>(a.array.size());
+    }
+    if (runs) a.optimize();
+}
+
+void subtract(Container& a, const Container& b_in) {
+    bool runs = (a.kind == Container::Kind::Run);
+    Container tmp;
+    const Container& b = expanded(b_in, tmp);
+    a.expand_runs();
+
+    if (a.kind == Container::Kind::Bitmap) {
+        if (b.kind == Container::Kind::Bitmap) {
+            for (std::size_t i = 0; i < Container::bitmap_words; ++i) a.bitmap[i] &= ~b.bitmap[i];
+        } else {
+            for (std::uint16_t low : b.array) a.bitmap[low / 64] &= ~(std::uint64_t{1} << (low % 64));
+        }
+        recount_bitmap(a);
+    } else {
+        std::erase_if(a.array, [&b](std::uint16_t low) { return b.contains(low); });
+        a.card = static_cast<std::uint32_t>(a.array.size());
+    }
+    if (runs) a.optimize();
+}
+
+/*
+ * Test whether all values of container a belong to container b.
+ */
+bool is_subset(const Container& a, const Container& b) {
+    if (a.card > b.card) return false;
+
+    if (a.kind == Container::Kind::Bitmap && b.kind == Container::Kind::Bitmap) {
+        for (std::size_t i = 0; i < Container::bitmap_words; ++i) {
+            if (a.bitmap[i] & ~b.bitmap[i]) return false;
+        }
+        return true;
+    }
+    bool subset = true;
+    a.for_each([&](std::uint16_t low) { subset = subset && b.contains(low); });
+    return subset;
+}
+
+}  // namespace
+
+}  // namespace roaring
+
+/*****************************************************
+ * Implementation of the member functions             *
+ ******************************************************/
+
+namespace {
+
+/*
+ * Map an int to 32 bits such that the unsigned order is the int order.
+ */
+std::uint32_t to_bits(int val) {
+    return static_cast<std::uint32_t>(val) ^ 0x80000000u;
+}
+
+int from_bits(std::uint16_t key, std::uint16_t low) {
+    return static_cast<int>(((std::uint32_t{key} << 16) | low) ^ 0x80000000u);
+}
+
+}  // namespace
+
+using roaring::Container;
+
+RoaringSet::RoaringSet(int val) {
+    append(val);
+}
+
+RoaringSet::RoaringSet(const std::vector<int>& list_of_values) {
+    for (int val : list_of_values) {
+        append(val);
+    }
+}
+
+/*
+ * The values of S are read with a cursor from setexpr.h.
+ */
+RoaringSet::RoaringSet(const Set& S) {
+    for (auto c = set_expr::SetLeaf{S}.cursor(); !c.done(); c.advance()) {
+        append(c.value());
+    }
+}
+
+Set RoaringSet::to_set() const {
+    return Set{to_vector()};
+}
+
+std::vector<int> RoaringSet::to_vector() const {
+    std::vector<int> values;
+    values.reserve(counter);
+    for (const Container& c : containers) {
+        c.for_each([&](std::uint16_t low) { values.push_back(from_bits(c.key, low)); });
+    }
+    return values;
+}
+
+void RoaringSet::make_empty() {
+    containers.clear();
+    counter = 0;
+}
+
+bool RoaringSet::is_member(int val) const {
+    std::uint32_t bits = to_bits(val);
+    std::uint16_t key = static_cast<std::uint16_t>(bits >> 16);
+
+    auto it = std::lower_bound(containers.begin(), containers.end(), key,
+                               [](const Container& c, std::uint16_t k) { return c.key < k; });
+    return it != containers.end() && it->key == key && it->contains(static_cast<std::uint16_t>(bits));
+}
+
+void RoaringSet::run_optimize() {
+    for (Container& c : containers) {
+        c.optimize();
+    }
+}
+
+size_t RoaringSet::memory_usage() const {
+    size_t bytes = sizeof(RoaringSet);
+    for (const Container& c : containers) {
+        bytes += c.bytes();
+    }
+    return bytes + (containers.capacity() - containers.size()) * sizeof(Container);
+}
+
+/*
+ * Containers with the same key are compared pairwise;
+ * a key present in only one of the sets rules out one inclusion.
+ */
+std::partial_ordering RoaringSet::operator<=>(const RoaringSet& S) const {
+    bool this_subset_S = counter <= S.counter;
+    bool S_subset_this = S.counter <= counter;
+
+    auto p1 = containers.begin();
+    auto p2 = S.containers.begin();
+
+    while ((this_subset_S || S_subset_this) && p1 != containers.end() && p2 != S.containers.end()) {
+        if (p1->key < p2->key) {
+            this_subset_S = false;
+            ++p1;
+        } else if (p2->key < p1->key) {
+            S_subset_this = false;
+            ++p2;
+        } else {
+            this_subset_S = this_subset_S && roaring::is_subset(*p1, *p2);
+            S_subset_this = S_subset_this && roaring::is_subset(*p2, *p1);
+            ++p1;
+            ++p2;
+        }
+    }
+    if (p1 != containers.end()) this_subset_S = false;
+    if (p2 != S.containers.end()) S_subset_this = false;
+
+    if (this_subset_S && S_subset_this)
+        return std::partial_ordering::equivalent;
+    else if (this_subset_S)
+        return std::partial_ordering::less;
+    else if (S_subset_this)
+        return std::partial_ordering::greater;
+    else
+        return std::partial_ordering::unordered;
+}
+
+bool RoaringSet::operator==(const RoaringSet& S) const {
+    return counter == S.counter && (*this <=> S) == std::partial_ordering::equivalent;
+}
+
+RoaringSet& RoaringSet::operator+=(const RoaringSet& S) {
+    if (this == &S) return *this;
+
+    std::vector<Container> result;
+    result.reserve(containers.size() + S.containers.size());
+
+    auto p1 = containers.begin();
+    auto p2 = S.containers.begin();
+    while (p1 != containers.end() || p2 != S.containers.end()) {
+        if (p2 == S.containers.end() || (p1 != containers.end() && p1->key < p2->key)) {
+            result.push_back(std::move(*p1++));
+        } else if (p1 == containers.end() || p2->key < p1->key) {
+            result.push_back(*p2++);
+        } else {
+            roaring::unite(*p1, *p2);
+            result.push_back(std::move(*p1++));
+            ++p2;
+        }
+    }
+    containers.swap(result);
+    update_counter();
+    return *this;
+}
+
+RoaringSet& RoaringSet::operator*=(const RoaringSet& S) {
+    if (this == &S) return *this;
+
+    std::vector<Container> result;
+    auto p2 = S.containers.begin();
+    for (Container& c : containers) {
+        while (p2 != S.containers.end() && p2->key < c.key) ++p2;
+        if (p2 == S.containers.end()) break;
+        if (p2->key == c.key) {
+            roaring::intersect(c, *p2);
+            if (c.card > 0) result.push_back(std::move(c));
+        }
+    }
+    containers.swap(result);
+    update_counter();
+    return *this;
+}
+
+RoaringSet& RoaringSet::operator-=(const RoaringSet& S) {
+    if (this == &S) {
+        make_empty();
+        return *this;
+    }
+
+    std::vector<Container> result;
+    result.reserve(containers.size());
+    auto p2 = S.containers.begin();
+    for (Container& c : containers) {
+        while (p2 != S.containers.end() && p2->key < c.key) ++p2;
+        if (p2 != S.containers.end() && p2->key == c.key) {
+            roaring::subtract(c, *p2);
+        }
+        if (c.card > 0) result.push_back(std::move(c));
+    }
+    containers.swap(result);
+    update_counter();
+    return *this;
+}
+
+/*****************************************************
+ * Private Member Functions -- Implementation         *
+ ******************************************************/
+
+void RoaringSet::append(int val) {
+    std::uint32_t bits = to_bits(val);
+    std::uint16_t key = static_cast<std::uint16_t>(bits >> 16);
+    std::uint16_t low = static_cast<std::uint16_t>(bits);
+
+    if (containers.empty() || containers.back().key != key) {
+        containers.push_back(Container{});
+        containers.back().key = key;
+    }
+
+    Container& c = containers.back();
+    if (c.kind == Container::Kind::Array) {
+        c.array.push_back(low);
+        if (c.array.size() > Container::array_max) c.to_bitmap();
+    } else {
+        c.bitmap[low / 64] |= std::uint64_t{1} << (low % 64);
+    }
+    ++c.card;
+    ++counter;
+}
+
+void RoaringSet::update_counter() {
+    counter = 0;
+    for (const Container& c : containers) {
+        counter += c.card;
+    }
+}
+
+void RoaringSet::write_to_stream(std::ostream& os) const {
+    if (counter == 0) {
+        os << "Set is empty!";
+    } else {
+        os << "{ ";
+        for (const Container& c : containers) {
+            c.for_each([&](std::uint16_t low) { os << from_bits(c.key, low) << " "; });
+        }
+        os << "}";
+    }
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <compare>  // C++20 three-way comparison operator
+#include <cstdint>
+
+#include "set.h"
+
+namespace roaring {
+
+/** Struct roaring::Container
+ *
+ * Stores the values of a RoaringSet whose 16 high bits are equal to key,
+ * represented by their 16 low bits, in one of three forms:
+ *   - Array:  increasingly sorted vector of the values (at most array_max values),
+ *   - Bitmap: 2^16 bits, bit i is set if value i belongs to the container,
+ *   - Run:    increasingly sorted vector of intervals [start, start + length].
+ * Only the vector matching kind is used, the others are empty.
+ */
+struct Container {
+    enum class Kind { Array, Bitmap, Run };
+
+    struct Run {
+        std::uint16_t start;
+        std::uint16_t length;  // the run holds length + 1 values
+    };
+
+    static constexpr std::uint32_t array_max = 4096;     // an array with more values is larger than a bitmap
+    static constexpr std::size_t bitmap_words = 65536 / 64;
+
+    std::uint16_t key = 0;
+    Kind kind = Kind::Array;
+    std::uint32_t card = 0;  // number of values in the container
+
+    std::vector<std::uint16_t> array;
+    std::vector<std::uint64_t> bitmap;
+    std::vector<Run> runs;
+
+    /*
+     * Test whether low belongs to the container.
+     */
+    bool contains(std::uint16_t low) const;
+
+    /*
+     * Convert to a bitmap container.
+     */
+    void to_bitmap();
+
+    /*
+     * Convert to an array container.
+     */
+    void to_array();
+
+    /*
+     * Convert run containers to an array or a bitmap container (whichever is smaller).
+     */
+    void expand_runs();
+
+    /*
+     * Choose the smallest of the three representations.
+     */
+    void optimize();
+
+    /*
+     * Number of bytes used by the values of the container.
+     */
+    std::size_t bytes() const;
+
+    /*
+     * Call f(low) for every value in the container, increasingly.
+     */
+    template <class F>
+    void for_each(F f) const;
+};
+
+}  // namespace roaring
+
+/** Class to represent a compressed Set of ints, for dense integer universes.
+ *
+ *  The int universe is split into chunks of 2^16 consecutive values and each non-empty
+ *  chunk is stored in a roaring::Container (sorted array, bitmap, or runs).
+ *  Union, intersection, and difference of two bitmap containers work on 64-bit words
+ *  (bitwise or, and, and-not) and count the result with popcount.
+ *
+ *  RoaringSet has the same operators as Set and can be converted to and from a Set.
+ */
+class RoaringSet {
+public:
+    /*
+     * Default constructor: create an empty RoaringSet.
+     */
+    RoaringSet() = default;
+
+    /*
+     * Conversion constructor: convert val into a singleton {val}.
+     */
+    RoaringSet(int val);
+
+    /*
+     * Constructor to create a RoaringSet from a sorted vector of unique ints.
+     * \param list_of_values is an increasingly sorted vector of unique ints.
+     */
+    explicit RoaringSet(const std::vector<int>& list_of_values);
+
+    /*
+     * Constructor to create a RoaringSet with the same values as Set S.
+     */
+    explicit RoaringSet(const Set& S);
+
+    /*
+     * Return a Set with the same values as *this.
+     */
+    Set to_set() const;
+
+    /*
+     * Return the values of the RoaringSet, increasingly sorted.
+     */
+    std::vector<int> to_vector() const;
+
+    /*
+     * Transform the RoaringSet into an empty set.
+     */
+    void make_empty();
+
+    /*
+     * Test whether val belongs to the RoaringSet.
+     */
+    bool is_member(int val) const;
+
+    /*
+     * Test whether the RoaringSet is empty.
+     */
+    bool is_empty() const {
+        return (counter == 0);
+    }
+
+    /*
+     * Count the number of values stored in the RoaringSet.
+     */
+    size_t cardinality() const {
+        return counter;
+    }
+
+    /*
+     * Convert every container into run containers when that uses less memory,
+     * e.g. for long ranges of consecutive values.
+     */
+    void run_optimize();
+
+    /*
+     * Return the number of bytes used by the RoaringSet.
+     */
+    size_t memory_usage() const;
+
+    /*
+     * Three-way comparison operator, with the same semantics as Set::operator<=>.
+     */
+    std::partial_ordering operator<=>(const RoaringSet& S) const;
+
+    /*
+     * Test whether RoaringSet *this and S represent the same set.
+     */
+    bool operator==(const RoaringSet& S) const;
+
+    /*
+     * Modify RoaringSet *this such that it becomes the union of *this with S.
+     */
+    RoaringSet& operator+=(const RoaringSet& S);
+
+    /*
+     * Modify RoaringSet *this such that it becomes the intersection of *this with S.
+     */
+    RoaringSet& operator*=(const RoaringSet& S);
+
+    /*
+     * Modify RoaringSet *this such that it becomes the set difference between *this and S.
+     */
+    RoaringSet& operator-=(const RoaringSet& S);
+
+    /* *******************************************
+     * Overloaded operators: non-member functions *
+     * ******************************************* */
+
+    /*
+     * Overloaded operator<<, writes S with the same format as a Set.
+     */
+    friend std::ostream& operator<<(std::ostream& os, const RoaringSet& S) {
+        S.write_to_stream(os);
+        return os;
+    }
+
+    /*
+     * Overloaded operator+: union S1 + S2.
+     */
+    friend RoaringSet operator+(RoaringSet S1, const RoaringSet& S2) {
+        return (S1 += S2);
+    }
+
+    /*
+     * Overloaded operator*: intersection S1 * S2.
+     */
+    friend RoaringSet operator*(RoaringSet S1, const RoaringSet& S2) {
+        return (S1 *= S2);
+    }
+
+    /*
+     * Overloaded operator-: difference S1 - S2.
+     */
+    friend RoaringSet operator-(RoaringSet S1, const RoaringSet& S2) {
+        return (S1 -= S2);
+    }
+
+private:
+    std::vector<roaring::Container> containers;  // Sorted by key
+    size_t counter = 0;                          // Number of values in the RoaringSet.
+
+    /*
+     * Add val, which must be larger than any value in the RoaringSet.
+     */
+    void append(int val);
+
+    /*
+     * Recompute counter from the containers.
+     */
+    void update_counter();
+
+    /*
+     * Write RoaringSet *this to stream os.
+     */
+    void write_to_stream(std::ostream& os) const;
+};
@@ -2,40 +2,112 @@
 
 #include <iostream>
 #include <vector>
+#include <span>
 #include <compare>  // C++20 three-way comparison operator
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <memory_resource>
+#include <type_traits>
 
-/** Class to represent a Set of ints.
+class ThreadPool;
+
+namespace set_expr {
+template <class S>
+class SetLeaf;
+template <class Op, class L, class R>
+class Binary;
+}  // namespace set_expr
+
+namespace set_file {
+class MappedSet;
+}  // namespace set_file
+
+/** Class template to represent a Set of values of type T.
  *
- *  Set is implemented as a sorted doubly linked list.
+ *  BasicSet is implemented as a sorted doubly linked list, ordered by Compare.
+ *  The two dummy nodes, and the first inline_capacity nodes of the list, are stored
+ *  inside the Set object: empty and small Sets do not allocate memory.
+ *  The other nodes are allocated with Allocator (from a NodePool shared by all Sets,
+ *  for the default std::allocator). With std::pmr::polymorphic_allocator (see pmr::Set below),
+ *  the nodes of a group of Sets can come from one memory_resource, e.g. a
+ *  std::pmr::monotonic_buffer_resource that releases them all at once.
+ *  A Set with more than inline_capacity values keeps its list in a separate body, which its copies
+ *  share (copy-on-write): copying takes O(1) time, and the list is copied only when one of the Sets
+ *  is modified.
  *  Sets should not contain repetitions, i.e.
- *  two ints with the same value cannot belong to a Set.
+ *  two equivalent values (neither is ordered before the other by Compare) cannot belong to a Set.
+ *
+ *  Sets are not thread-safe: several threads can read the same Set, but not while it is modified
+ *  (copying a Set only reads it). All Sets share the Node counter (see get_count_nodes) and,
+ *  with the default allocator, a NodePool: Sets are created, modified and destroyed by one thread
+ *  at a time. ConcurrentSet (see concurrentset.h) can be shared by several threads.
+ *
+ *  T must be default constructible (for the dummy nodes) and copyable,
+ *  and std::hash<T> must be defined (see hash()).
+ *  Set is BasicSet<int>, instantiated in set.cpp.
  *
  *  All Set operations must have a linear time complexity, in the worst case.
  */
-class Set {
+template <class T, class Compare = std::less<T>, class Allocator = std::allocator<T>>
+class BasicSet {
 public:
+    using value_type = T;
+    using key_compare = Compare;
+    using allocator_type = Allocator;
+
     /*
      * Default constructor: create an empty Set.
+     * No memory is allocated, the dummy nodes are stored in the Set.
      */
-    Set();
+    BasicSet() : BasicSet(Compare{}, Allocator{}) {
+    }
+
+    /*
+     * Create an empty Set ordered by comp, whose nodes will be allocated with alloc.
+     */
+    explicit BasicSet(const Compare& comp, const Allocator& alloc = Allocator{});
+
+    /*
+     * Create an empty Set, whose nodes will be allocated with alloc.
+     */
+    explicit BasicSet(const Allocator& alloc) : BasicSet(Compare{}, alloc) {
+    }
 
     /*
      * Conversion constructor: convert val into a singleton {val}.
      */
-    Set(int val);
+    BasicSet(const T& val, const Allocator& alloc = Allocator{});
 
     /*
-     * Constructor to create a Set from a sorted vector of unique ints.
-     * \param list_of_values is an increasingly sorted vector of unique ints.
+     * Constructor to create a Set from a vector of values.
+     * \param list_of_values is usually an increasingly sorted vector of unique values,
+     * otherwise a sorted copy without repetitions is made first.
      */
-    explicit Set(const std::vector<int>& list_of_values);
+    explicit BasicSet(const std::vector<T>& list_of_values, const Allocator& alloc = Allocator{});
 
     /*
      * Copy constructor: create a new Set as a copy of Set S.
      * \param S Set to be copied.
      * Function does not modify Set S in any way.
+     * If S has more than inline_capacity values, no node is copied: both Sets
+     * read the Shared body of S until one of them is modified.
+     * The allocator of the copy is given by std::allocator_traits::select_on_container_copy_construction.
+     */
+    BasicSet(const BasicSet& S);
+
+    /*
+     * Copy constructor, with the allocator of the copy.
+     * The list is shared only if alloc is equal to the allocator of S.
+     */
+    BasicSet(const BasicSet& S, const Allocator& alloc);
+
+    /*
+     * Move constructor: create a new Set by taking over the list of Set S.
+     * \param S Set whose nodes are transferred to *this, S becomes empty.
+     * Only the (at most inline_capacity) nodes stored inside S are copied, thus O(1).
      */
-    Set(const Set& S);
+    BasicSet(BasicSet&& S) noexcept;
 
     /*
      * Transform the Set into an empty set.
@@ -46,22 +118,116 @@ public:
     /*
      * Destructor: deallocate all memory (Nodes) allocated for the list.
      */
-    ~Set();
+    ~BasicSet();
 
     /*
      * Assignment operator: assign new contents to the *this Set,
      * replacing its current content.
-     * \param S Set to be copied into Set *this.
+     * \param S Set to be copied (or moved, if it is an rvalue) into Set *this.
      * Use copy-and-swap idiom -- see TNG033: lecture 5.
+     * Thus, this function acts both as copy and move assignment.
+     * The allocator of *this does not change: if it differs from the allocator of S,
+     * the values of S are copied.
+     */
+    BasicSet& operator=(BasicSet S);
+
+    /*
+     * Return the allocator of the Set.
+     */
+    allocator_type get_allocator() const {
+        return alloc;
+    }
+
+    /*
+     * Return the comparison object of the Set.
      */
-    Set& operator=(Set S);
+    key_compare key_comp() const {
+        return comp;
+    }
 
     /*
      * Test whether val belongs to the Set.
      * Return true if val belongs to the set, otherwise false.
      * This function does not modify the Set in any way.
+     * Sets with at least index_threshold values have a skip-list index (see setindex.h),
+     * searched in O(log n) expected time. The index is kept up to date by the operations
+     * that modify the Set: insert and erase update it, and the other operations rebuild it
+     * once done (in linear time, like the operations themselves).
+     */
+    bool is_member(const T& val) const;
+
+    /*
+     * Tag to select the are_members overload for queries in any order: S.are_members(q, Set::unsorted).
+     */
+    struct unsorted_t {
+        explicit unsorted_t() = default;
+    };
+    static constexpr unsorted_t unsorted{};
+
+    /*
+     * Test whether each value of sorted_queries belongs to the Set.
+     * Return a vector with element i true if sorted_queries[i] belongs to the set.
+     * Requirement: sorted_queries is sorted in non-decreasing order (checked by an assert in debug builds).
+     * A single merge pass over the Set and the queries: O(n + k) time.
+     */
+    std::vector<bool> are_members(std::span<const T> sorted_queries) const;
+
+    /*
+     * Same as above, for queries in any order: the queries are sorted first,
+     * in O(k log k) time, and then merged with the Set.
+     */
+    std::vector<bool> are_members(std::span<const T> queries, unsorted_t) const;
+
+    /*
+     * Order statistics. For Sets with at least index_threshold values, the skip-list index
+     * counts the Nodes it skips, so that these take O(log n) expected time (plus the size of the output).
+     */
+
+    /*
+     * Return the number of values in the Set that are smaller than val.
+     */
+    size_t rank(const T& val) const;
+
+    /*
+     * Return the k-th smallest value in the Set, starting from k = 0.
+     * Requirement: k < cardinality() (checked by an assert in debug builds).
+     */
+    const T& select(size_t k) const;
+
+    /*
+     * Return the values of the Set in the interval [lo, hi), increasingly sorted.
+     */
+    std::vector<T> range(const T& lo, const T& hi) const;
+
+    /*
+     * Insert val in the Set, if it does not belong to the Set yet.
+     * Return true if val was inserted, otherwise false.
+     * Expected O(log n) time, if the Set is indexed.
      */
-    bool is_member(int val) const;
+    bool insert(const T& val);
+
+    /*
+     * Remove val from the Set, if it belongs to the Set.
+     * Return true if val was removed, otherwise false.
+     * Expected O(log n) time, if the Set is indexed.
+     */
+    bool erase(const T& val);
+
+    /*
+     * Insert all values of a batch in the Set, in a single pass through the list.
+     * Nodes are allocated only for the values that do not belong to the Set yet.
+     * \param values is usually increasingly sorted without repetitions,
+     * otherwise a sorted copy without repetitions is made first.
+     * Return the number of values inserted.
+     */
+    size_t insert_range(std::span<const T> values);
+
+    /*
+     * Remove all values of a batch from the Set, in a single pass through the list.
+     * \param values as for insert_range.
+     * Return the number of values removed.
+     */
+    size_t erase_range(std::span<const T> values);
 
     /*
      * Test whether the Set is empty.
@@ -89,41 +255,120 @@ public:
      * Return std::partial_ordering::greater if *this > S (*this contains S).
      * Return std::partial_ordering::unordered otherwise (Sets *this and S are not comparable).
      * Requirement: should iterate through each set no more than once.
+     * Sets of the same cardinality but different hash are unordered, found in O(1) time.
      */
-    std::partial_ordering operator<=>(const Set& S) const;
+    std::partial_ordering operator<=>(const BasicSet& S) const;
 
     /*
      * Test whether Set *this and S represent the same set.
      * Return true if *this has the same elements as S,
      * false otherwise.
      * Requirement: should iterate through each set no more than once.
+     * Sets of different cardinality or hash are rejected in O(1) time.
+     */
+    bool operator==(const BasicSet& S) const;
+
+    /*
+     * Return a hash of the Set, independent of how the Set was built: equal Sets have equal hashes.
+     * The hash is maintained as the Set is modified, so this takes O(1) time.
+     * It is computed from the std::hash<T> of the values, which must be consistent with Compare.
+     */
+    size_t hash() const;
+
+    /*
+     * Cardinality-only queries: the result Set is never built, nothing is allocated,
+     * and each set is iterated through no more than once.
+     */
+
+    /*
+     * Return the number of elements of the intersection of *this with S.
+     */
+    size_t intersection_size(const BasicSet& S) const;
+
+    /*
+     * Return the number of elements of the union of *this with S.
+     */
+    size_t union_size(const BasicSet& S) const;
+
+    /*
+     * Return the number of elements of the set difference between *this and S.
+     */
+    size_t difference_size(const BasicSet& S) const;
+
+    /*
+     * Return the Jaccard similarity |*this * S| / |*this + S|, or 1.0 if both sets are empty.
+     */
+    double jaccard(const BasicSet& S) const;
+
+    /*
+     * Test whether *this and S have no element in common.
+     * Stops at the first common element.
      */
-    bool operator==(const Set& S) const;
+    bool is_disjoint(const BasicSet& S) const;
 
     /*
      * Modify Set *this such that it becomes the union of *this with Set S.
      * Set *this is modified and then returned.
+     * If S is a singleton, this is the same as insert.
      */
-    Set& operator+=(const Set& S);
+    BasicSet& operator+=(const BasicSet& S);
+
+    /*
+     * Union with a Set S that is about to be destroyed.
+     * The nodes of S whose values do not belong to *this are moved into *this,
+     * instead of allocating new nodes (if both Sets have equal allocators).
+     */
+    BasicSet& operator+=(BasicSet&& S);
 
     /*
      * Modify Set *this such that it becomes the intersection of *this with Set S.
      * Set *this is modified and then returned.
      */
-    Set& operator*=(const Set& S);
+    BasicSet& operator*=(const BasicSet& S);
 
     /*
      * Modify Set *this such that it becomes the set difference between *this and S.
      * Set *this is modified and then returned.
+     * If S is a singleton, this is the same as erase.
+     */
+    BasicSet& operator-=(const BasicSet& S);
+
+    /*
+     * Return the union of all Sets in sets, computed on the threads of pool (by default, ThreadPool::shared()).
+     * The Sets are merged in groups (one per thread) with a k-way merge, and the merged groups
+     * are merged pairwise in parallel: O(N log k / p + N) time for N values in total, p threads.
+     * Requirement: the Sets are ordered by equivalent comparison objects, and are not modified
+     * during the call. The result has the comparison object and allocator of the first Set.
+     * Defined in setparallel.h (compiled in set.cpp for Set).
      */
-    Set& operator-=(const Set& S);
+    static BasicSet union_all(std::span<const BasicSet* const> sets, ThreadPool& pool);
+    static BasicSet union_all(std::span<const BasicSet* const> sets);
 
     /*
-     * Return the number of existing nodes.
+     * Return the intersection of all Sets in sets, computed on the threads of pool.
+     * The values of the smallest Set are filtered by the other Sets, by increasing cardinality,
+     * and the computation stops as soon as no value is left. Requirements as for union_all.
+     */
+    static BasicSet intersect_all(std::span<const BasicSet* const> sets, ThreadPool& pool);
+    static BasicSet intersect_all(std::span<const BasicSet* const> sets);
+
+    /*
+     * Return the number of existing nodes (of all Sets with the same template arguments).
      * Used solely for debug purposes.
      */
     static int get_count_nodes();
 
+    /*
+     * Bidirectional iterators over the values of the Set, in increasing order (see setiterator.h).
+     * The values cannot be modified through an iterator, since the list must stay sorted.
+     * Any modification of the Set, or moving it, invalidates its iterators; copying the Set does not.
+     */
+    class const_iterator;
+    using iterator = const_iterator;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+
     /* *******************************************
      * Overloaded operators: non-member functions *
      * ******************************************* */
@@ -132,45 +377,76 @@ public:
       * Overloaded operator<<.
       * \param os ostream object where the set S elements are written.
       */
-    friend std::ostream& operator<<(std::ostream& os, const Set& S) {
+    friend std::ostream& operator<<(std::ostream& os, const BasicSet& S) {
         S.write_to_stream(os);
         return os;
     }
 
     /*
-     * Overloaded operator+: Set union S1 + S2.
-     * S1 + S2 is the set of elements in S1 or S2 (without repetitions).
-     * Return a new Set representing the union of S1 with S2.
-     */
-    friend Set operator+(Set S1, const Set& S2) {
-        return (S1 += S2);
-    }
-
-    /*
-     * Overloaded operator*: Set intersection S1 * S2.
-     * S1 * S2 is the set of elements in both S1 and S2.
-     * Return a new Set representing the intersection of S1 with S2.
+     * Overloaded operators +, *, and - (union, intersection, and difference)
+     * are declared in setexpr.h: they build lazy expressions, evaluated when converted to a Set.
      */
-    friend Set operator*(Set S1, const Set& S2) {
-        return (S1 *= S2);
-    }
-
-    /*
-     * Overloaded operator-: Set difference S1 - S2.
-     * S1 - S2 is the set of elements in S1 that do not belong to S2.
-     * Return a new Set representing the set difference S1 - S2.
-     */
-    friend Set operator-(Set S1, const Set& S2) {
-        return (S1 -= S2);
-    }
 
 private:
     // Forward declaration of the Node class (its full definition must be in node.h)
     class Node;
 
-    Node* head;      // Pointer to the dummy header node.
-    Node* tail;      // Pointer to the dummy tail node.
-    size_t counter;  // Number of values in the Set.
+    // Forward declaration of the skip-list index class (its full definition is in setindex.h)
+    class Index;
+
+    // Reference-counted list shared by copies of a Set (defined in setimpl.h)
+    struct Shared;
+
+    // Sets with fewer values are not indexed, a linear search is fast enough
+    static constexpr size_t index_threshold = 64;
+
+    // Number of nodes stored inside the Set object, before nodes are allocated with the Allocator
+    static constexpr int inline_capacity = 8;
+
+    // Raw memory for a Node (node.h is included at the end of this file, before Sets are instantiated)
+    struct NodeStorage {
+        alignas(Node) unsigned char bytes[sizeof(Node)];
+    };
+
+    // Nodes that are not stored in the Set are allocated with this allocator
+    using NodeAllocator = typename std::allocator_traits<Allocator>::template rebind_alloc<Node>;
+
+    // The default allocator is replaced by the NodePool of the Node class
+    static constexpr bool uses_node_pool = std::is_same_v<Allocator, std::allocator<T>>;
+
+    // Set expressions (see setexpr.h) read the lists and build their result directly
+    template <class S>
+    friend class set_expr::SetLeaf;
+    template <class Op, class L, class R>
+    friend class set_expr::Binary;
+
+    // Set files (see setfile.h) append the values read from a mapping
+    friend class set_file::MappedSet;
+
+    Node* head;          // Pointer to the dummy header node (of the Shared body, if any).
+    Node* tail;          // Pointer to the dummy tail node (of the Shared body, if any).
+    size_t counter;      // Number of values in the Set.
+
+    // Sum of the hashes of the values in the Set (wraps around), updated by
+    // insert_node and remove_node: the order of the insertions does not matter.
+    std::uint64_t hash_sum;
+
+    // Skip-list index over the list, or nullptr if the Set has fewer than index_threshold values
+    // (a Set reading a Shared body uses the index of the body instead).
+    // The operations that modify the list without updating the index (e.g. operator*=)
+    // discard it, and build a new one when they are done.
+    Index* index;
+
+    NodeStorage dummy_nodes[2];                          // The dummy header and tail nodes
+    NodeStorage inline_nodes[inline_capacity];           // Nodes of the list stored in the Set
+    std::uint8_t inline_used;                            // Bit i is set if inline_nodes[i] holds a Node
+
+    // Body whose list this Set reads, or nullptr if the Set has at most inline_capacity values
+    // and keeps its list in its own dummy and inline nodes
+    Shared* shared;
+
+    [[no_unique_address]] Compare comp;     // Order of the values
+    [[no_unique_address]] Allocator alloc;  // Allocator of the nodes (not of the inline nodes)
 
     /* **************************
      * Private Member Functions *
@@ -181,7 +457,7 @@ private:
       * \param p pointer to a Node.
       * \param val value to be inserted after position p.
       */
-    void insert_node(Node* p, int val);
+    void insert_node(Node* p, const T& val);
 
     /*
      * Remove the Node pointed by p.
@@ -189,8 +465,173 @@ private:
      */
     void remove_node(Node* p);
 
+    /*
+     * Create a Node storing val, in a free inline node if there is one and the list is not
+     * in a Shared body, otherwise with the Allocator.
+     */
+    Node* allocate_node(const T& val);
+
+    /*
+     * Create a Node storing val with the Allocator.
+     */
+    Node* allocate_external_node(const T& val);
+
+    /*
+     * Destroy the Node pointed by p, created by allocate_node.
+     */
+    void free_node(Node* p);
+
+    /*
+     * Test whether p points to one of the inline nodes of the Set.
+     */
+    bool is_inline(const Node* p) const;
+
+    /*
+     * Move all nodes of Set S into the empty Set *this, leaving S empty.
+     * The inline nodes of S are copied into the inline nodes of *this.
+     * If the allocators of the Sets differ, all values of S are copied instead.
+     */
+    void take_list(BasicSet& S);
+
+    /*
+     * Append the values produced by cursor c (see setexpr.h) at the end of the list.
+     * The values must be increasing and greater than any value in the Set.
+     */
+    template <class Cursor>
+    void append_from(Cursor c);
+
+    /*
+     * Merge the lists of the Sets in group into out (see setparallel.h).
+     * Requirement: group is not empty.
+     */
+    static void merge_all(std::span<const BasicSet* const> group, std::vector<T>& out);
+
+    /*
+     * Append to out the values of the sorted candidates that belong to the Set, searching with idx
+     * (the index of the Set, or nullptr). Does not modify the Set, so that threads can call it concurrently.
+     */
+    void keep_members(std::span<const T> candidates, const Index* idx, std::vector<T>& out) const;
+
+    /*
+     * Create a Shared body with an empty list, read by one Set.
+     */
+    Shared* new_body();
+
+    /*
+     * Free the list and the index of body, which no Set reads any more.
+     */
+    void delete_body(Shared* body);
+
+    /*
+     * Move the list of the Set to a new Shared body, if the Set has more than inline_capacity
+     * values and no body yet. The value of the Set does not change.
+     */
+    void share();
+
+    /*
+     * Before the Set is modified: if other Sets read its Shared body,
+     * copy the list to a new body read only by this Set.
+     */
+    void unshare();
+
+    /*
+     * Stop reading the Shared body, deleting it if no other Set reads it.
+     * The Set becomes empty.
+     */
+    void release();
+
+    /*
+     * Make the Set empty and read its own dummy nodes again, after its Shared body was
+     * released or passed to another Set.
+     */
+    void detach();
+
+    /*
+     * Return the index of the Set, or nullptr if the Set is too small to be indexed.
+     */
+    Index* get_index() const;
+
+    /*
+     * Build the index, if the Set is large enough and has none.
+     */
+    void build_index();
+
+    /*
+     * Discard the index, since the list is about to be modified without updating it.
+     */
+    void drop_index();
+
+    /*
+     * Called at the end of the operations that add values or discard the index:
+     * move a large list to a Shared body (see share) and build its index.
+     */
+    void finish_update();
+
+    /*
+     * Test whether the nodes of S can be freed with the allocator of *this.
+     */
+    bool equal_allocators(const BasicSet& S) const {
+        if constexpr (std::allocator_traits<Allocator>::is_always_equal::value)
+            return true;
+        else
+            return alloc == S.alloc;
+    }
+
+    /*
+     * Test whether a and b are equivalent, i.e. neither is ordered before the other.
+     */
+    bool equivalent(const T& a, const T& b) const {
+        return !comp(a, b) && !comp(b, a);
+    }
+
+    /*
+     * Hash of a single value, for hash_sum.
+     */
+    static std::uint64_t hash_value(const T& val);
+
+    /*
+     * Return values if it is increasingly sorted without repetitions, otherwise
+     * a sorted copy of values without repetitions, stored in buffer.
+     */
+    std::span<const T> sorted_unique(std::span<const T> values, std::vector<T>& buffer) const;
+
     /*
      * Write Set *this to stream os.
      */
     void write_to_stream(std::ostream& os) const;
 };
+
+/*
+ * Sets can be used as keys of the unordered standard containers.
+ */
+template <class T, class Compare, class Allocator>
+struct std::hash<BasicSet<T, Compare, Allocator>> {
+    size_t operator()(const BasicSet<T, Compare, Allocator>& S) const noexcept {
+        return S.hash();
+    }
+};
+
+#include "node.h"
+#include "setindex.h"
+#include "setexpr.h"
+#include "setiterator.h"
+#include "setimpl.h"
+
+/*
+ * Set of ints: BasicSet<int> is explicitly instantiated in set.cpp.
+ */
+using Set = BasicSet<int>;
+
+extern template class BasicSet<int>;
+
+static_assert(std::bidirectional_iterator<Set::const_iterator>);
+
+namespace pmr {
+
+/*
+ * Sets whose nodes are allocated from a std::pmr::memory_resource.
+ */
+template <class T, class Compare = std::less<T>>
+using Set = BasicSet<T, Compare, std::pmr::polymorphic_allocator<T>>;
+
+}  // namespace pmr
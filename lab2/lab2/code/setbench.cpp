@@ -0,0 +1,408 @@
+/*
+ * Benchmark of Set (and the FlatSet, RoaringSet and UnrolledSet variants) against std::set<int>,
+ * a sorted std::vector<int> with the std:: set algorithms, and std::unordered_set<int>.
+ *
+ * Times construction, is_member, <=>, union, intersection, and difference for
+ * sizes 10^2 .. 10^max, several overlap ratios between the two operands, and two
+ * value distributions. Results are written to stdout as JSON.
+ *
+ * The scaling exponent of the linear-time Set operations is fitted (log-log least squares)
+ * and the program exits with status 1 if it indicates worse than linear time.
+ * A list traversal gets much slower per node once the list no longer fits in the caches,
+ * which inflates the exponent of the raw times. Thus, each time is divided by the time of a plain
+ * traversal of the lists of the two operands (measured for the same sizes and values), and the
+ * exponent of this ratio is checked: about 0 for linear time, and about 1 for quadratic time.
+ *
+ * Usage: SetBench [--max-exp e] [--repeat r]     (build in Release mode)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <set>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "set.h"
+#include "flatset.h"
+#include "roaringset.h"
+#include "unrolledset.h"
+
+namespace {
+
+/* ******************************************************
+ * Adapters: the same operations for every set structure *
+ * ****************************************************** */
+
+template <class S>
+struct SetLikeAdapter {  // Set, FlatSet, RoaringSet, UnrolledSet
+    static S build(const std::vector<int>& values) {
+        return S{values};
+    }
+    static size_t size(const S& A) {
+        return A.cardinality();
+    }
+    static bool member(const S& A, int x) {
+        return A.is_member(x);
+    }
+    static bool subset(const S& A, const S& B) {
+        return A <= B;
+    }
+    static size_t unite(const S& A, const S& B) {
+        S R{A};
+        R += B;
+        return R.cardinality();
+    }
+    static size_t intersect(const S& A, const S& B) {
+        S R{A};
+        R *= B;
+        return R.cardinality();
+    }
+    static size_t subtract(const S& A, const S& B) {
+        S R{A};
+        R -= B;
+        return R.cardinality();
+    }
+};
+
+struct StdSetAdapter {
+    using S = std::set<int>;
+    static S build(const std::vector<int>& values) {
+        return S(values.begin(), values.end());
+    }
+    static size_t size(const S& A) {
+        return A.size();
+    }
+    static bool member(const S& A, int x) {
+        return A.contains(x);
+    }
+    static bool subset(const S& A, const S& B) {
+        return std::includes(B.begin(), B.end(), A.begin(), A.end());
+    }
+    static size_t unite(const S& A, const S& B) {
+        S R{A};
+        R.insert(B.begin(), B.end());
+        return R.size();
+    }
+    static size_t intersect(const S& A, const S& B) {
+        S R;
+        std::set_intersection(A.begin(), A.end(), B.begin(), B.end(), std::inserter(R, R.end()));
+        return R.size();
+    }
+    static size_t subtract(const S& A, const S& B) {
+        S R;
+        std::set_difference(A.begin(), A.end(), B.begin(), B.end(), std::inserter(R, R.end()));
+        return R.size();
+    }
+};
+
+struct SortedVectorAdapter {
+    using S = std::vector<int>;
+    static S build(const std::vector<int>& values) {
+        return values;
+    }
+    static size_t size(const S& A) {
+        return A.size();
+    }
+    static bool member(const S& A, int x) {
+        return std::binary_search(A.begin(), A.end(), x);
+    }
+    static bool subset(const S& A, const S& B) {
+        return std::includes(B.begin(), B.end(), A.begin(), A.end());
+    }
+    static size_t unite(const S& A, const S& B) {
+        S R;
+        R.reserve(A.size() + B.size());
+        std::set_union(A.begin(), A.end(), B.begin(), B.end(), std::back_inserter(R));
+        return R.size();
+    }
+    static size_t intersect(const S& A, const S& B) {
+        S R;
+        std::set_intersection(A.begin(), A.end(), B.begin(), B.end(), std::back_inserter(R));
+        return R.size();
+    }
+    static size_t subtract(const S& A, const S& B) {
+        S R;
+        std::set_difference(A.begin(), A.end(), B.begin(), B.end(), std::back_inserter(R));
+        return R.size();
+    }
+};
+
+struct UnorderedSetAdapter {
+    using S = std::unordered_set<int>;
+    static S build(const std::vector<int>& values) {
+        return S(values.begin(), values.end());
+    }
+    static size_t size(const S& A) {
+        return A.size();
+    }
+    static bool member(const S& A, int x) {
+        return A.contains(x);
+    }
+    static bool subset(const S& A, const S& B) {
+        return A.size() <= B.size() && std::all_of(A.begin(), A.end(), [&B](int x) { return B.contains(x); });
+    }
+    static size_t unite(const S& A, const S& B) {
+        S R{A};
+        R.insert(B.begin(), B.end());
+        return R.size();
+    }
+    static size_t intersect(const S& A, const S& B) {
+        const S& small = (A.size() < B.size()) ? A : B;
+        const S& large = (A.size() < B.size()) ? B : A;
+        S R;
+        for (int x : small) {
+            if (large.contains(x)) R.insert(x);
+        }
+        return R.size();
+    }
+    static size_t subtract(const S& A, const S& B) {
+        S R;
+        for (int x : A) {
+            if (!B.contains(x)) R.insert(x);
+        }
+        return R.size();
+    }
+};
+
+/* ************************
+ * Workload generation     *
+ * ************************ */
+
+enum class Distribution { Uniform, Dense };
+
+const char* name(Distribution d) {
+    return (d == Distribution::Uniform) ? "uniform" : "dense";
+}
+
+/*
+ * Two sorted vectors of n unique values each, sharing about overlap * n values.
+ * Uniform: values spread over [0, 8n). Dense: consecutive values with ~10% gaps.
+ */
+std::pair<std::vector<int>, std::vector<int>> make_operands(size_t n, double overlap, Distribution d,
+                                                            std::mt19937& rng) {
+    std::vector<int> pool;  // 2n unique values, A takes the first n, B shares some of them
+    pool.reserve(2 * n);
+    if (d == Distribution::Uniform) {
+        std::uniform_int_distribution<int> value(0, static_cast<int>(8 * n));
+        std::unordered_set<int> seen;
+        while (pool.size() < 2 * n) {
+            int x = value(rng);
+            if (seen.insert(x).second) pool.push_back(x);
+        }
+    } else {
+        for (int x = 0; pool.size() < 2 * n; ++x) {
+            if (rng() % 10 != 0) pool.push_back(x);
+        }
+        std::shuffle(pool.begin(), pool.end(), rng);
+    }
+
+    size_t shared = static_cast<size_t>(overlap * static_cast<double>(n));
+    std::vector<int> A(pool.begin(), pool.begin() + n);
+    std::vector<int> B(pool.begin(), pool.begin() + shared);
+    B.insert(B.end(), pool.begin() + n, pool.begin() + (2 * n - shared));
+
+    std::sort(A.begin(), A.end());
+    std::sort(B.begin(), B.end());
+    return {A, B};
+}
+
+/* ************************
+ * Measurements            *
+ * ************************ */
+
+using Clock = std::chrono::steady_clock;
+
+volatile size_t sink = 0;  // results are written here, so that work is not optimized away
+
+/*
+ * Best of repeat runs of f, in nanoseconds.
+ */
+template <class F>
+double time_ns(int repeat, F f) {
+    double best = 1e300;
+    for (int r = 0; r < repeat; ++r) {
+        auto start = Clock::now();
+        f();
+        best = std::min(best, std::chrono::duration<double, std::nano>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+struct Result {
+    std::string structure;
+    std::string operation;
+    std::string distribution;
+    double overlap;
+    size_t n;
+    double ns;
+};
+
+template <class Adapter>
+void run(const char* structure, const std::vector<int>& a, const std::vector<int>& b, double overlap,
+         Distribution d, int repeat, const std::vector<int>& queries, std::vector<Result>& results) {
+    size_t n = a.size();
+    auto add = [&](const char* op, double ns) {
+        results.push_back(Result{structure, op, name(d), overlap, n, ns});
+    };
+
+    add("construction", time_ns(repeat, [&] { sink = sink + Adapter::size(Adapter::build(a)); }));
+
+    auto A = Adapter::build(a);
+    auto B = Adapter::build(b);
+
+    double member_ns = time_ns(repeat, [&] {
+        size_t hits = 0;
+        for (int x : queries) hits += Adapter::member(A, x);
+        sink = sink + hits;
+    });
+    add("is_member", member_ns / static_cast<double>(queries.size()));  // per query
+
+    add("subset", time_ns(repeat, [&] { sink = sink + Adapter::subset(A, A) + Adapter::subset(A, B); }));
+    add("union", time_ns(repeat, [&] { sink = sink + Adapter::unite(A, B); }));
+    add("intersection", time_ns(repeat, [&] { sink = sink + Adapter::intersect(A, B); }));
+    add("difference", time_ns(repeat, [&] { sink = sink + Adapter::subtract(A, B); }));
+}
+
+/*
+ * Time of a traversal of the lists of Sets A{a} and B{b}: the reference for the complexity check.
+ */
+double traversal_ns(const std::vector<int>& a, const std::vector<int>& b, int repeat) {
+    const Set A{a};
+    const Set B{b};
+    return time_ns(repeat, [&] {
+        size_t sum = 0;
+        for (int x : A) sum += static_cast<size_t>(x);
+        for (int x : B) sum += static_cast<size_t>(x);
+        sink = sink + sum;
+    });
+}
+
+/*
+ * Least squares slope of log(ns) as a function of log(n).
+ */
+double scaling_exponent(const std::vector<std::pair<double, double>>& points) {
+    double sx = 0, sy = 0, sxx = 0, sxy = 0;
+    for (auto [n, ns] : points) {
+        double x = std::log(n), y = std::log(ns);
+        sx += x;
+        sy += y;
+        sxx += x * x;
+        sxy += x * y;
+    }
+    double k = static_cast<double>(points.size());
+    return (k * sxy - sx * sy) / (k * sxx - sx * sx);
+}
+
+void write_json(std::ostream& os, const std::vector<Result>& results, const std::vector<std::string>& checks,
+                bool passed) {
+    os << "{\n  \"results\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const Result& r = results[i];
+        double per_element = (r.operation == "is_member") ? r.ns : r.ns / static_cast<double>(r.n);
+        os << "    {\"structure\": \"" << r.structure << "\", \"operation\": \"" << r.operation
+           << "\", \"distribution\": \"" << r.distribution << "\", \"overlap\": " << r.overlap
+           << ", \"n\": " << r.n << ", \"ns\": " << r.ns << ", \"ns_per_element\": " << per_element << "}"
+           << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    os << "  ],\n  \"complexity_check\": {\n    \"passed\": " << (passed ? "true" : "false")
+       << ",\n    \"exponents\": [\n";
+    for (size_t i = 0; i < checks.size(); ++i) {
+        os << "      " << checks[i] << (i + 1 < checks.size() ? "," : "") << "\n";
+    }
+    os << "    ]\n  }\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+    int max_exp = 7;
+    int repeat = 3;
+    for (int i = 1; i < argc; i += 2) {
+        std::string option{argv[i]};
+        const char* value = i + 1 < argc ? argv[i + 1] : nullptr;  // nullptr for a last option without its value
+        if (value != nullptr && option == "--max-exp") {
+            max_exp = std::atoi(value);
+        } else if (value != nullptr && option == "--repeat") {
+            repeat = std::atoi(value);
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--max-exp e] [--repeat r]\n";
+            return 2;
+        }
+    }
+
+    // Exponent of time / traversal time above which an operation is not considered linear
+    // (halfway between linear, 0, and quadratic, 1)
+    constexpr double max_relative_exponent = 0.5;
+
+    std::mt19937 rng{2025};
+    std::vector<Result> results;
+
+    for (Distribution d : {Distribution::Uniform, Distribution::Dense}) {
+        for (double overlap : {0.0, 0.5, 1.0}) {
+            for (size_t n = 100; n <= static_cast<size_t>(std::pow(10, max_exp)); n *= 10) {
+                auto [a, b] = make_operands(n, overlap, d, rng);
+
+                std::vector<int> queries(1000);
+                std::uniform_int_distribution<int> value(0, a.back());
+                for (int& x : queries) x = value(rng);
+
+                run<SetLikeAdapter<Set>>("Set", a, b, overlap, d, repeat, queries, results);
+                results.push_back(Result{"Set", "traversal", name(d), overlap, n, traversal_ns(a, b, repeat)});
+                run<SetLikeAdapter<FlatSet>>("FlatSet", a, b, overlap, d, repeat, queries, results);
+                run<SetLikeAdapter<RoaringSet>>("RoaringSet", a, b, overlap, d, repeat, queries, results);
+                run<SetLikeAdapter<UnrolledSet>>("UnrolledSet", a, b, overlap, d, repeat, queries, results);
+                run<StdSetAdapter>("std::set", a, b, overlap, d, repeat, queries, results);
+                run<SortedVectorAdapter>("sorted std::vector", a, b, overlap, d, repeat, queries, results);
+                run<UnorderedSetAdapter>("std::unordered_set", a, b, overlap, d, repeat, queries, results);
+            }
+        }
+    }
+
+    // set.h requires linear time for every Set operation: fit the exponents for Set, from n = 1000 on
+    std::vector<std::string> checks;
+    bool passed = true;
+    for (const char* op : {"construction", "subset", "union", "intersection", "difference"}) {
+        for (Distribution d : {Distribution::Uniform, Distribution::Dense}) {
+            for (double overlap : {0.0, 0.5, 1.0}) {
+                auto measured = [&](const char* operation) {
+                    std::vector<std::pair<double, double>> points;
+                    for (const Result& r : results) {
+                        if (r.structure == "Set" && r.operation == operation && r.distribution == name(d) &&
+                            r.overlap == overlap && r.n >= 1000) {
+                            points.emplace_back(static_cast<double>(r.n), std::max(r.ns, 1.0));
+                        }
+                    }
+                    return points;
+                };
+                std::vector<std::pair<double, double>> points = measured(op);
+                std::vector<std::pair<double, double>> relative = measured("traversal");  // same sizes, same order
+                if (points.size() < 2) continue;
+                for (size_t i = 0; i < points.size(); ++i) {
+                    relative[i].second = points[i].second / relative[i].second;
+                }
+
+                double exponent = scaling_exponent(points);
+                double relative_exponent = scaling_exponent(relative);
+                bool linear = relative_exponent <= max_relative_exponent;
+                passed = passed && linear;
+                checks.push_back(std::string{"{\"operation\": \""} + op + "\", \"distribution\": \"" + name(d) +
+                                 "\", \"overlap\": " + std::to_string(overlap) +
+                                 ", \"exponent\": " + std::to_string(exponent) +
+                                 ", \"relative_exponent\": " + std::to_string(relative_exponent) +
+                                 ", \"linear\": " + (linear ? "true" : "false") + "}");
+            }
+        }
+    }
+
+    write_json(std::cout, results, checks, passed);
+    if (!passed) {
+        std::cerr << "Set operations scale worse than linearly, see complexity_check\n";
+        return 1;
+    }
+}
@@ -0,0 +1,405 @@
+#pragma once
+
+#include <iostream>
+#include <concepts>
+#include <type_traits>
+
+#include "set.h"
+#include "node.h"
+
+/** Lazy Set algebra: expression templates for S1 + S2, S1 * S2, and S1 - S2.
+ *
+ * The operators +, *, - do not compute a new Set. Instead, they return a small
+ * expression object (a tree whose leaves refer to the operand Sets or store value operands).
+ * When an expression is converted to a Set (e.g. assigned to a Set), all its leaves are
+ * merged in one simultaneous pass, and nodes are only allocated for the values of the result.
+ * Thus, no intermediate Sets are created for chains like A + B * C - D.
+ *
+ * An expression refers to its operand Sets, hence it must be converted to a Set
+ * before its operands are modified or destroyed (do not store expressions in auto variables).
+ */
+namespace set_expr {
+
+/* ************************************************************
+ * Cursors: walk increasingly through the values of an operand *
+ * A cursor offers done(), value(), and advance()              *
+ * ************************************************************ */
+
+/*
+ * Leaf storing a reference to a Set of type S.
+ */
+template <class S>
+class SetLeaf {
+public:
+    using set_type = S;
+
+    explicit SetLeaf(const S& S1) : S1{&S1} {
+    }
+
+    class Cursor {
+    public:
+        explicit Cursor(const S& S1) : p{S1.head->next}, end{S1.tail} {
+        }
+        bool done() const {
+            return p == end;
+        }
+        const typename S::value_type& value() const {
+            return p->value;
+        }
+        void advance() {
+            p = p->next;
+        }
+
+    private:
+        const typename S::Node* p;
+        const typename S::Node* end;
+    };
+
+    Cursor cursor() const {
+        return Cursor{*S1};
+    }
+
+    const S& set() const {
+        return *S1;
+    }
+
+private:
+    const S* S1;
+};
+
+/*
+ * Leaf storing a value operand, i.e. the singleton {val}.
+ * No Set is created for it.
+ */
+template <class T>
+class ValueLeaf {
+public:
+    using set_type = void;  // the type of Set is given by the other operand
+
+    explicit ValueLeaf(const T& val) : val{val} {
+    }
+
+    class Cursor {
+    public:
+        explicit Cursor(const T& val) : val{&val}, consumed{false} {
+        }
+        bool done() const {
+            return consumed;
+        }
+        const T& value() const {
+            return *val;
+        }
+        void advance() {
+            consumed = true;
+        }
+
+    private:
+        const T* val;  // value of the leaf, which outlives the cursor
+        bool consumed;
+    };
+
+    Cursor cursor() const {
+        return Cursor{val};
+    }
+
+private:
+    T val;
+};
+
+/*
+ * Union: values of a or b.
+ */
+struct Union {
+    template <class C1, class C2, class Compare>
+    class Cursor {
+    public:
+        Cursor(C1 a, C2 b, const Compare& comp) : a{a}, b{b}, comp{comp} {
+        }
+        bool done() const {
+            return a.done() && b.done();
+        }
+        decltype(auto) value() const {
+            if (a.done()) return b.value();
+            if (b.done()) return a.value();
+            return comp(b.value(), a.value()) ? b.value() : a.value();
+        }
+        void advance() {
+            // Both cursors are advanced if their values are equivalent
+            bool advance_a = !a.done() && (b.done() || !comp(b.value(), a.value()));
+            bool advance_b = !b.done() && (a.done() || !comp(a.value(), b.value()));
+            if (advance_a) a.advance();
+            if (advance_b) b.advance();
+        }
+
+    private:
+        C1 a;
+        C2 b;
+        [[no_unique_address]] Compare comp;
+    };
+};
+
+/*
+ * Intersection: values of a that are also in b.
+ */
+struct Intersection {
+    template <class C1, class C2, class Compare>
+    class Cursor {
+    public:
+        Cursor(C1 a, C2 b, const Compare& comp) : a{a}, b{b}, comp{comp} {
+            settle();
+        }
+        bool done() const {
+            return a.done() || b.done();
+        }
+        decltype(auto) value() const {
+            return a.value();
+        }
+        void advance() {
+            a.advance();
+            b.advance();
+            settle();
+        }
+
+    private:
+        C1 a;
+        C2 b;
+        [[no_unique_address]] Compare comp;
+
+        // Skip values until a and b agree (or one of them is exhausted)
+        void settle() {
+            while (!a.done() && !b.done()) {
+                if (comp(a.value(), b.value()))
+                    a.advance();
+                else if (comp(b.value(), a.value()))
+                    b.advance();
+                else
+                    break;
+            }
+        }
+    };
+};
+
+/*
+ * Difference: values of a that are not in b.
+ */
+struct Difference {
+    template <class C1, class C2, class Compare>
+    class Cursor {
+    public:
+        Cursor(C1 a, C2 b, const Compare& comp) : a{a}, b{b}, comp{comp} {
+            settle();
+        }
+        bool done() const {
+            return a.done();
+        }
+        decltype(auto) value() const {
+            return a.value();
+        }
+        void advance() {
+            a.advance();
+            settle();
+        }
+
+    private:
+        C1 a;
+        C2 b;
+        [[no_unique_address]] Compare comp;
+
+        // Skip the values of a that are in b
+        void settle() {
+            while (!a.done() && !b.done() && !comp(a.value(), b.value())) {
+                if (comp(b.value(), a.value())) {
+                    b.advance();
+                } else {
+                    a.advance();
+                    b.advance();
+                }
+            }
+        }
+    };
+};
+
+/*
+ * Expression node: Op applied to the operands l and r.
+ * The type of the result, its order and its allocator are those of the leftmost Set operand.
+ */
+template <class Op, class L, class R>
+class Binary {
+public:
+    using set_type = std::conditional_t<std::is_void_v<typename L::set_type>, typename R::set_type, typename L::set_type>;
+    using Cursor = typename Op::template Cursor<typename L::Cursor, typename R::Cursor, typename set_type::key_compare>;
+
+    Binary(L l, R r) : l{l}, r{r} {
+    }
+
+    Cursor cursor() const {
+        return Cursor{l.cursor(), r.cursor(), set().key_comp()};
+    }
+
+    /*
+     * Return the leftmost Set operand.
+     */
+    const set_type& set() const {
+        if constexpr (std::is_void_v<typename L::set_type>)
+            return r.set();
+        else
+            return l.set();
+    }
+
+    /*
+     * Evaluate the expression: a single merge of all leaves,
+     * allocating one node per value of the result.
+     */
+    operator set_type() const {
+        set_type result{set().key_comp(), set().get_allocator()};
+        result.append_from(cursor());
+        return result;
+    }
+
+    /*
+     * Overloaded operator<<: write the value of the expression.
+     */
+    friend std::ostream& operator<<(std::ostream& os, const Binary& E) {
+        return os << static_cast<set_type>(E);
+    }
+
+private:
+    L l;
+    R r;
+};
+
+template <class T>
+inline constexpr bool is_set_v = false;
+
+template <class T, class Compare, class Allocator>
+inline constexpr bool is_set_v<BasicSet<T, Compare, Allocator>> = true;
+
+template <class T>
+inline constexpr bool is_expression_v = false;
+
+template <class Op, class L, class R>
+inline constexpr bool is_expression_v<Binary<Op, L, R>> = true;
+
+template <class T>
+concept Expression = is_expression_v<std::remove_cvref_t<T>>;
+
+// A Set or an expression producing a Set
+template <class T>
+concept SetLike = is_set_v<std::remove_cvref_t<T>> || Expression<T>;
+
+// Type of the Set that a Set or an expression produces
+template <class T>
+struct set_type_of {
+    using type = typename T::set_type;
+};
+
+template <class T, class Compare, class Allocator>
+struct set_type_of<BasicSet<T, Compare, Allocator>> {
+    using type = BasicSet<T, Compare, Allocator>;
+};
+
+template <SetLike T>
+using set_type_t = typename set_type_of<std::remove_cvref_t<T>>::type;
+
+// A value operand for Sets of type S: a value_type, an integer for Sets of integers,
+// or anything convertible to value_type that is not a number (e.g. a string literal)
+template <class V, class S>
+concept ValueOf = !SetLike<V> && (std::same_as<std::remove_cvref_t<V>, typename S::value_type> ||
+                                  (std::integral<std::remove_cvref_t<V>> && std::integral<typename S::value_type>) ||
+                                  (!std::is_arithmetic_v<std::remove_cvref_t<V>> && std::convertible_to<const V&, typename S::value_type>));
+
+namespace detail {
+
+template <class L, class R>
+constexpr bool are_operands() {
+    if constexpr (SetLike<L> && SetLike<R>)
+        return std::same_as<set_type_t<L>, set_type_t<R>>;
+    else if constexpr (SetLike<L>)
+        return ValueOf<R, set_type_t<L>>;
+    else if constexpr (SetLike<R>)
+        return ValueOf<L, set_type_t<R>>;
+    else
+        return false;
+}
+
+}  // namespace detail
+
+// Operands of +, *, -: Sets or expressions of the same type of Set, or one of them a value
+template <class L, class R>
+concept Operands = detail::are_operands<L, R>();
+
+/*
+ * Wrap an operand into an expression tree node, for Sets of type S.
+ */
+template <class S, class X>
+auto as_operand(const X& x) {
+    if constexpr (is_set_v<X>)
+        return SetLeaf<S>{x};
+    else if constexpr (Expression<X>)
+        return x;
+    else
+        return ValueLeaf<typename S::value_type>{typename S::value_type(x)};
+}
+
+template <class Op, class L, class R>
+auto make(const L& S1, const R& S2) {
+    using S = set_type_t<std::conditional_t<SetLike<L>, L, R>>;
+    using LeafL = decltype(as_operand<S>(S1));
+    using LeafR = decltype(as_operand<S>(S2));
+    return Binary<Op, LeafL, LeafR>{as_operand<S>(S1), as_operand<S>(S2)};
+}
+
+}  // namespace set_expr
+
+/*
+ * Evaluate cursor c, which must produce increasing values, appending its values to the list.
+ */
+template <class T, class Compare, class Allocator>
+template <class Cursor>
+void BasicSet<T, Compare, Allocator>::append_from(Cursor c) {
+    Node* p = tail->prev;
+    for (; !c.done(); c.advance()) {
+        insert_node(p, c.value());
+        p = p->next;
+        ++counter;
+    }
+    finish_update();
+}
+
+/* *******************************************
+ * Overloaded operators: non-member functions *
+ * ******************************************* */
+
+/*
+ * Overloaded operator+: Set union S1 + S2.
+ * S1 + S2 is the set of elements in S1 or S2 (without repetitions).
+ * S1 and S2 can be Sets, values, or Set expressions (at least one of them is not a value).
+ * Return an expression representing the union of S1 with S2.
+ */
+template <class L, class R>
+    requires set_expr::Operands<L, R>
+auto operator+(const L& S1, const R& S2) {
+    return set_expr::make<set_expr::Union>(S1, S2);
+}
+
+/*
+ * Overloaded operator*: Set intersection S1 * S2.
+ * S1 * S2 is the set of elements in both S1 and S2.
+ * Return an expression representing the intersection of S1 with S2.
+ */
+template <class L, class R>
+    requires set_expr::Operands<L, R>
+auto operator*(const L& S1, const R& S2) {
+    return set_expr::make<set_expr::Intersection>(S1, S2);
+}
+
+/*
+ * Overloaded operator-: Set difference S1 - S2.
+ * S1 - S2 is the set of elements in S1 that do not belong to S2.
+ * Return an expression representing the set difference S1 - S2.
+ */
+template <class L, class R>
+    requires set_expr::Operands<L, R>
+auto operator-(const L& S1, const R& S2) {
+    return set_expr::make<set_expr::Difference>(S1, S2);
+}
@@ -0,0 +1,370 @@
+#include "setfile.h"
+#include <algorithm>
+#include <bit>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <stdexcept>
+#include <system_error>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace set_file {
+
+namespace {
+
+constexpr char magic[8] = {'L', 'A', 'B', '2', 'S', 'E', 'T', '\0'};
+constexpr size_t header_size = 32;
+
+// The values are encoded in blocks of this size before being written
+constexpr size_t write_buffer_size = size_t{1} << 20;
+
+/*
+ * Little-endian loads and stores, whatever the byte order of the CPU.
+ */
+template <class U>
+U load(const unsigned char* p) {
+    U val;
+    std::memcpy(&val, p, sizeof(U));
+    if constexpr (std::endian::native == std::endian::big) val = std::byteswap(val);
+    return val;
+}
+
+template <class U>
+void store(unsigned char* p, U val) {
+    if constexpr (std::endian::native == std::endian::big) val = std::byteswap(val);
+    std::memcpy(p, &val, sizeof(U));
+}
+
+/*
+ * Tell the operating system how the mapping is read: at random places by the binary searches of
+ * is_member (no read ahead), in order by to_set and to_vector (read ahead, and the pages read can be
+ * dropped early). Only a hint, so errors are ignored. Windows has no such hint for mapped views.
+ */
+void advise(const unsigned char* data, size_t size, bool sequential) {
+#ifdef _WIN32
+    (void)data, (void)size, (void)sequential;
+#else
+    ::madvise(const_cast<unsigned char*>(data), size, sequential ? MADV_SEQUENTIAL : MADV_RANDOM);
+#endif
+}
+
+/*
+ * Advise sequential reads of a mapping for the lifetime of the object, then random reads again.
+ */
+class SequentialScan {
+public:
+    SequentialScan(const unsigned char* data, size_t size) : data{data}, size{size} {
+        advise(data, size, true);
+    }
+
+    ~SequentialScan() {
+        advise(data, size, false);
+    }
+
+    SequentialScan(const SequentialScan&) = delete;
+    SequentialScan& operator=(const SequentialScan&) = delete;
+
+private:
+    const unsigned char* data;
+    size_t size;
+};
+
+[[noreturn]] void bad_file(const std::string& what) {
+    throw std::runtime_error("not a valid Set file: " + what);
+}
+
+/*
+ * Write the header, then the count values of the range, encoded into a buffer flushed when full.
+ * The size in the header is written last, once it is known.
+ */
+template <class Range>
+void write_values(const std::string& path, const Range& values, size_t count, Encoding encoding) {
+    std::ofstream os{path, std::ios::binary | std::ios::trunc};
+    if (!os) throw std::system_error(errno, std::generic_category(), "cannot create " + path);
+
+    unsigned char header[header_size] = {};
+    std::memcpy(header, magic, sizeof(magic));
+    store<std::uint32_t>(header + 8, version);
+    store<std::uint32_t>(header + 12, static_cast<std::uint32_t>(encoding));
+    store<std::uint64_t>(header + 16, count);
+    os.write(reinterpret_cast<const char*>(header), header_size);
+
+    std::vector<unsigned char> buffer;
+    buffer.reserve(write_buffer_size + 16);
+    std::uint64_t size = 0;
+    auto flush = [&] {
+        os.write(reinterpret_cast<const char*>(buffer.data()), static_cast<std::streamsize>(buffer.size()));
+        size += buffer.size();
+        buffer.clear();
+    };
+
+    bool first = true;
+    std::uint32_t prev = 0;
+    for (int val : values) {
+        std::uint32_t bits = static_cast<std::uint32_t>(val);
+        size_t n = buffer.size();
+        if (encoding == Encoding::raw || first) {
+            buffer.resize(n + 4);
+            store<std::uint32_t>(buffer.data() + n, bits);
+            first = false;
+        } else {
+            std::uint32_t delta = bits - prev;  // modulo 2^32, the values are increasing
+            while (delta >= 0x80) {
+                buffer.push_back(static_cast<unsigned char>(delta | 0x80));
+                delta >>= 7;
+            }
+            buffer.push_back(static_cast<unsigned char>(delta));
+        }
+        prev = bits;
+        if (buffer.size() >= write_buffer_size) flush();
+    }
+    flush();
+
+    store<std::uint64_t>(header + 24, size);
+    os.seekp(24);
+    os.write(reinterpret_cast<const char*>(header + 24), 8);
+    os.flush();
+    if (!os) throw std::system_error(errno, std::generic_category(), "cannot write " + path);
+}
+
+}  // namespace
+
+/*****************************************************
+ * Writers                                            *
+ ******************************************************/
+
+void write(const std::string& path, const Set& S, Encoding encoding) {
+    write_values(path, S, S.cardinality(), encoding);
+}
+
+void write(const std::string& path, std::span<const int> sorted_values, Encoding encoding) {
+    write_values(path, sorted_values, sorted_values.size(), encoding);
+}
+
+/*****************************************************
+ * MappedSet                                          *
+ ******************************************************/
+
+/*
+ * Cursor over the values of the file (see setexpr.h), checking that they are increasing
+ * and that the payload holds exactly count values.
+ */
+class MappedSet::Cursor {
+public:
+    Cursor(std::span<const unsigned char> bytes, Encoding encoding, size_t count)
+        : p{bytes.data()}, end{bytes.data() + bytes.size()}, encoding{encoding}, left{count} {
+        if (left > 0) {
+            if (end - p < 4) bad_file("truncated values");
+            current = load<std::uint32_t>(p);
+            p += 4;
+        } else if (p != end) {
+            bad_file("values after the last one");
+        }
+    }
+
+    bool done() const {
+        return left == 0;
+    }
+
+    int value() const {
+        return static_cast<int>(current);
+    }
+
+    void advance() {
+        if (--left == 0) {
+            if (p != end) bad_file("values after the last one");
+            return;
+        }
+
+        std::uint32_t next;
+        if (encoding == Encoding::raw) {
+            if (end - p < 4) bad_file("truncated values");
+            next = load<std::uint32_t>(p);
+            p += 4;
+        } else {
+            std::uint32_t delta = 0;
+            for (int shift = 0;; shift += 7) {
+                if (p == end || shift > 28) bad_file("truncated or invalid delta");
+                unsigned char byte = *p++;
+                delta |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0) break;
+            }
+            next = current + delta;
+        }
+        if (!(static_cast<int>(current) < static_cast<int>(next))) bad_file("values not increasing");
+        current = next;
+    }
+
+private:
+    const unsigned char* p;
+    const unsigned char* end;
+    Encoding encoding;
+    size_t left;  // number of values not read yet, including current
+    std::uint32_t current = 0;
+};
+
+/*
+ * The file is closed once mapped (on POSIX, the mapping keeps it alive).
+ * The header is checked before any value is read.
+ */
+MappedSet::MappedSet(const std::string& path) {
+#ifdef _WIN32
+    file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                       FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        file = nullptr;
+        throw std::system_error(static_cast<int>(GetLastError()), std::system_category(), "cannot open " + path);
+    }
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file, &file_size)) {
+        auto error = static_cast<int>(GetLastError());
+        CloseHandle(file);
+        throw std::system_error(error, std::system_category(), "cannot read the size of " + path);
+    }
+    size = static_cast<size_t>(file_size.QuadPart);
+    if (size < header_size) {
+        CloseHandle(file);
+        bad_file(path + " is too short");
+    }
+    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    if (view == nullptr) {
+        auto error = static_cast<int>(GetLastError());
+        if (mapping != nullptr) CloseHandle(mapping);
+        CloseHandle(file);
+        throw std::system_error(error, std::system_category(), "cannot map " + path);
+    }
+    data = static_cast<const unsigned char*>(view);
+#else
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "cannot open " + path);
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        int error = errno;
+        ::close(fd);
+        throw std::system_error(error, std::generic_category(), "cannot read the size of " + path);
+    }
+    size = static_cast<size_t>(st.st_size);
+    if (size < header_size) {
+        ::close(fd);
+        bad_file(path + " is too short");
+    }
+    void* view = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+    int error = errno;
+    ::close(fd);
+    if (view == MAP_FAILED) throw std::system_error(error, std::generic_category(), "cannot map " + path);
+    data = static_cast<const unsigned char*>(view);
+#endif
+
+    try {
+        if (std::memcmp(data, magic, sizeof(magic)) != 0) bad_file(path + " has no Set header");
+        std::uint32_t file_version = load<std::uint32_t>(data + 8);
+        if (file_version == 0 || file_version > version) {
+            bad_file(path + " has unsupported version " + std::to_string(file_version));
+        }
+        std::uint32_t file_encoding = load<std::uint32_t>(data + 12);
+        if (file_encoding > static_cast<std::uint32_t>(Encoding::delta)) bad_file(path + " has an unknown encoding");
+        enc = static_cast<Encoding>(file_encoding);
+        std::uint64_t file_count = load<std::uint64_t>(data + 16);
+        std::uint64_t payload_size = load<std::uint64_t>(data + 24);
+        if (payload_size != size - header_size) bad_file(path + " does not match the size in its header");
+        bool count_matches = enc == Encoding::raw
+                                 ? payload_size % 4 == 0 && payload_size / 4 == file_count
+                                 : (file_count == 0 ? payload_size == 0 : payload_size >= 4 && payload_size - 3 >= file_count);  // 4 + 1 + ... + 1 bytes
+        if (!count_matches) bad_file(path + " does not match the count in its header");
+        count = static_cast<size_t>(file_count);
+    } catch (...) {
+        unmap();
+        throw;
+    }
+    advise(data, size, false);  // see SequentialScan for to_set and to_vector
+}
+
+MappedSet::~MappedSet() {
+    unmap();
+}
+
+void MappedSet::unmap() {
+    if (data == nullptr) return;
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+    CloseHandle(mapping);
+    CloseHandle(file);
+#else
+    ::munmap(const_cast<unsigned char*>(data), size);
+#endif
+    data = nullptr;
+}
+
+std::span<const int> MappedSet::values() const {
+    if (enc != Encoding::raw || std::endian::native != std::endian::little) {
+        throw std::logic_error("MappedSet::values: the file cannot be read in place");
+    }
+    // The header is 32 bytes long and the mapping is page aligned, so the values are aligned
+    return {reinterpret_cast<const int*>(data + header_size), count};
+}
+
+bool MappedSet::is_member(int val) const {
+    if (enc == Encoding::raw && std::endian::native == std::endian::little) {
+        auto v = values();
+        return std::binary_search(v.begin(), v.end(), val);
+    }
+    for (Cursor c{payload(), enc, count}; !c.done(); c.advance()) {
+        if (c.value() >= val) return c.value() == val;
+    }
+    return false;
+}
+
+/*
+ * The values are appended at the end of the list as they are read (see Set::append_from).
+ */
+Set MappedSet::to_set() const {
+    SequentialScan scan{data, size};
+    Set S;
+    S.append_from(Cursor{payload(), enc, count});
+    return S;
+}
+
+/*
+ * A raw file is copied as a block, then checked in a second pass over the copy.
+ */
+std::vector<int> MappedSet::to_vector() const {
+    SequentialScan scan{data, size};
+    if (enc == Encoding::raw && std::endian::native == std::endian::little) {
+        auto v = values();
+        std::vector<int> result(v.begin(), v.end());
+        if (std::adjacent_find(result.begin(), result.end(), std::greater_equal<int>{}) != result.end()) {
+            bad_file("values not increasing");
+        }
+        return result;
+    }
+
+    std::vector<int> result;
+    result.reserve(count);
+    for (Cursor c{payload(), enc, count}; !c.done(); c.advance()) {
+        result.push_back(c.value());
+    }
+    return result;
+}
+
+std::span<const unsigned char> MappedSet::payload() const {
+    return {data + header_size, size - header_size};
+}
+
+Set read(const std::string& path) {
+    return MappedSet{path}.to_set();
+}
+
+}  // namespace set_file
@@ -0,0 +1,129 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string>
+#include <vector>
+
+#include "set.h"
+
+/*
+ * Binary files of Sets of ints, read without parsing through a memory mapping.
+ *
+ * Format (all numbers little-endian):
+ *   offset  0  magic     8 bytes, "LAB2SET" and a 0 byte
+ *   offset  8  version   uint32, currently 1 (readers reject newer versions)
+ *   offset 12  encoding  uint32, 0 = raw, 1 = delta
+ *   offset 16  count     uint64, number of values
+ *   offset 24  size      uint64, number of bytes after the header
+ *   offset 32  values    increasingly sorted, without repetitions:
+ *              raw:   count int32, so that the mapping can be read in place
+ *              delta: the first value (as uint32), then the difference of each value with the previous one,
+ *                     as a LEB128 varint (7 bits per byte, least significant first): about 1 to 2 bytes
+ *                     per value for dense Sets, instead of 4
+ */
+namespace set_file {
+
+enum class Encoding : std::uint32_t { raw = 0, delta = 1 };
+
+inline constexpr std::uint32_t version = 1;
+
+/*
+ * Write the values of S to the file at path, replacing it.
+ * Throw std::system_error if the file cannot be written.
+ */
+void write(const std::string& path, const Set& S, Encoding encoding = Encoding::raw);
+
+/*
+ * Same as above, for the values of a FlatSet or any other increasingly sorted array of unique ints.
+ */
+void write(const std::string& path, std::span<const int> sorted_values, Encoding encoding = Encoding::raw);
+
+/** Class to read a Set file through a read-only memory mapping (mmap, or MapViewOfFile on Windows).
+ *
+ *  The constructor only maps the file and checks its header: the values are read from the
+ *  mapping, on demand, by the operating system. A raw file can be used in place, without copying
+ *  it (values, is_member), or converted to a Set in one pass.
+ *  The mapping is released by the destructor.
+ */
+class MappedSet {
+public:
+    /*
+     * Map the file at path.
+     * Throw std::system_error if it cannot be opened or mapped,
+     * and std::runtime_error if it is not a Set file of a supported version.
+     */
+    explicit MappedSet(const std::string& path);
+
+    ~MappedSet();
+
+    MappedSet(const MappedSet&) = delete;
+    MappedSet& operator=(const MappedSet&) = delete;
+
+    Encoding encoding() const {
+        return enc;
+    }
+
+    /*
+     * Count the number of values stored in the file.
+     */
+    size_t cardinality() const {
+        return count;
+    }
+
+    /*
+     * Return the values of a raw file, in place in the mapping.
+     * Requirement: encoding() == Encoding::raw, on a little-endian CPU (otherwise std::logic_error is thrown).
+     * The values are not checked: see to_set.
+     */
+    std::span<const int> values() const;
+
+    /*
+     * Test whether val belongs to the Set of the file.
+     * Binary search in raw files (O(log n)), a pass through the values of delta files.
+     */
+    bool is_member(int val) const;
+
+    /*
+     * Return a Set with the values of the file, in a single pass.
+     * Throw std::runtime_error if the values are not increasing, or do not match the header.
+     */
+    Set to_set() const;
+
+    /*
+     * Return the values of the file, with the same checks as to_set.
+     */
+    std::vector<int> to_vector() const;
+
+private:
+    // Reads the values of the file, for to_set and to_vector (defined in setfile.cpp)
+    class Cursor;
+
+    const unsigned char* data = nullptr;  // Beginning of the mapping (the header)
+    size_t size = 0;                      // Size of the mapping (the file)
+    Encoding enc = Encoding::raw;
+    size_t count = 0;
+
+#ifdef _WIN32
+    void* file = nullptr;     // HANDLE of the file
+    void* mapping = nullptr;  // HANDLE of the file mapping
+#endif
+
+    /*
+     * Release the mapping (and, on Windows, the file).
+     */
+    void unmap();
+
+    /*
+     * The values, after the header.
+     */
+    std::span<const unsigned char> payload() const;
+};
+
+/*
+ * Read the Set stored in the file at path (MappedSet(path).to_set()).
+ */
+Set read(const std::string& path);
+
+}  // namespace set_file
@@ -0,0 +1,1147 @@
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <iostream>
+#include <vector>
+#include <compare>
+#include <bit>
+#include <functional>
+#include <utility>
+#include <algorithm>
+
+#include "set.h"
+#include "node.h"
+#include "setindex.h"
+
+/** Implementation of the member functions of class template BasicSet.
+ *
+ * The definitions are in this header, since they are templates. set.cpp instantiates
+ * them once for Set (BasicSet<int>), the other Sets are instantiated where they are used.
+ */
+
+/*
+ * List of a Set with more than inline_capacity values, shared by the copies of the Set:
+ * its dummy nodes and its index. The other nodes of the list are allocated with the Allocator
+ * (equal for all the Sets reading the body), none of them is an inline node of a Set.
+ * The Shared body itself, like the index, is allocated with the global operator new.
+ */
+template <class T, class Compare, class Allocator>
+struct BasicSet<T, Compare, Allocator>::Shared {
+    NodeStorage dummy_nodes[2];   // The dummy header and tail nodes of the list
+    Index* index = nullptr;       // Index of the list, or nullptr
+    std::atomic<size_t> refs{1};  // Number of Sets reading the list, which is modified only if there is one
+};
+
+/*
+ * Hash of a single value, for hash_sum: the splitmix64 finalizer of std::hash<T>.
+ * A sum of well-mixed value hashes is unlikely to be equal for different Sets.
+ */
+template <class T, class Compare, class Allocator>
+std::uint64_t BasicSet<T, Compare, Allocator>::hash_value(const T& val) {
+    std::uint64_t x = static_cast<std::uint64_t>(std::hash<T>{}(val)) + 0x9e3779b97f4a7c15ull;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ull;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebull;
+    return x ^ (x >> 31);
+}
+
+/*
+ * One pass checks that values is already sorted by comp without repetitions.
+ */
+template <class T, class Compare, class Allocator>
+std::span<const T> BasicSet<T, Compare, Allocator>::sorted_unique(std::span<const T> values, std::vector<T>& buffer) const {
+    auto not_increasing = [this](const T& a, const T& b) { return !comp(a, b); };
+    if (std::adjacent_find(values.begin(), values.end(), not_increasing) == values.end()) {
+        return values;
+    }
+    buffer.assign(values.begin(), values.end());
+    std::sort(buffer.begin(), buffer.end(), comp);
+    buffer.erase(std::unique(buffer.begin(), buffer.end(), [this](const T& a, const T& b) { return !comp(a, b); }),
+                 buffer.end());
+    return buffer;
+}
+
+/*****************************************************
+ * Implementation of the member functions             *
+ ******************************************************/
+
+
+// Definition of static member function get_count_nodes()
+template <class T, class Compare, class Allocator>
+int BasicSet<T, Compare, Allocator>::get_count_nodes() {
+    return Node::count_nodes;
+}
+ /*
+  * Create an empty Set, ordered by comp, whose nodes are allocated with alloc.
+  * The two dummy nodes are created in the storage of the Set and point to each other.
+  */
+template <class T, class Compare, class Allocator>
+BasicSet<T, Compare, Allocator>::BasicSet(const Compare& comp, const Allocator& alloc)
+    : counter{ 0 }, hash_sum{ 0 }, index{ nullptr }, inline_used{ 0 }, shared{ nullptr }, comp{ comp }, alloc{ alloc } {
+    // Create dummy head and tail
+    head = new (dummy_nodes[0].bytes) Node{};  // value is arbitrary, not used
+    tail = new (dummy_nodes[1].bytes) Node{};
+    head->next = tail;
+    tail->prev = head;
+    // No other nodes yet, so counter remains 0.
+}
+
+/*
+ * Conversion constructor: convert val into a singleton {val}.
+ * We call the default constructor to set up the empty list with dummy nodes,
+ * then we insert the new node between head and tail.
+ */
+template <class T, class Compare, class Allocator>
+BasicSet<T, Compare, Allocator>::BasicSet(const T& val, const Allocator& alloc) : BasicSet(alloc) {  // delegate to the empty Set constructor
+    insert_node(head, val);
+    counter = 1;
+}
+
+/*
+ * Constructor to create a Set from a vector of values.
+ * The vector is checked to be sorted increasingly, with unique values, in one pass;
+ * otherwise the nodes are created from a sorted copy without repetitions.
+ */
+template <class T, class Compare, class Allocator>
+BasicSet<T, Compare, Allocator>::BasicSet(const std::vector<T>& list_of_values, const Allocator& alloc)
+    : BasicSet(alloc) {  // delegate to the empty Set constructor
+    std::vector<T> buffer;
+    Node* p = head;
+    // Insert each value at the end (always before the tail)
+    for (const T& val : sorted_unique(list_of_values, buffer)) {
+        insert_node(p, val);  // insert after the last inserted node
+        p = p->next;         // move to the newly inserted node
+        ++counter;
+    }
+    finish_update();
+}
+
+/*
+ * Copy constructor: create a new Set as a copy of Set S.
+ */
+template <class T, class Compare, class Allocator>
+BasicSet<T, Compare, Allocator>::BasicSet(const BasicSet& S)
+    : BasicSet(S, std::allocator_traits<Allocator>::select_on_container_copy_construction(S.alloc)) {
+}
+
+/*
+ * A large Set is shared: *this reads the Shared body of S too, if the nodes
+ * of the list were allocated with an allocator equal to alloc. Only the reference count
+ * of the body changes (atomically), S itself is not modified.
+ * Otherwise, we iterate S's list to copy each node (into the inline nodes of *this).
+ */
+template <class T, class Compare, class Allocator>
+BasicSet<T, Compare, Allocator>::BasicSet(const BasicSet& S, const Allocator& alloc)
+    : BasicSet(S.comp, alloc) {  // delegate to the empty Set constructor
+    if (S.shared != nullptr && equal_allocators(S)) {
+        shared = S.shared;
+        shared->refs.fetch_add(1, std::memory_order_relaxed);
+        head = S.head;
+        tail = S.tail;
+        counter = S.counter;
+        hash_sum = S.hash_sum;
+        return;
+    }
+
+    Node* current_S = S.head->next;
+    Node* p = head; // pointer to last inserted node in new list
+    while (current_S != S.tail) {
+        insert_node(p, current_S->value);
+        p = p->next;
+        ++counter;
+        current_S = current_S->next;
+    }
+    finish_update();
+}
+
+/*
+ * Move constructor: take over the list of S.
+ * Only the inline nodes of S are copied, into the inline nodes of *this.
+ */
+template <class T, class Compare, class Allocator>
+BasicSet<T, Compare, Allocator>::BasicSet(BasicSet&& S) noexcept : BasicSet(S.comp, S.alloc) {  // delegate to the empty Set constructor
+    take_list(S);
+}
+
+/*
+ * Transform the Set into an empty set.
+ * Remove all nodes from the list except the dummy nodes.
+ */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::make_empty() {
+    if (shared != nullptr) {
+        release();
+        return;
+    }
+    drop_index();
+    // Start after the dummy head
+    Node* current = head->next;
+    // Remove nodes until reaching the dummy tail
+    while (current != tail) {
+        Node* temp = current;
+        current = current->next;
+        remove_node(temp);
+    }
+    // After removing all nodes, relink dummy head and tail
+    head->next = tail;
+    tail->prev = head;
+    counter = 0;
+    hash_sum = 0;
+}
+
+/*
+ * Destructor: deallocate all memory (Nodes) allocated for the list.
+ */
+template <class T, class Compare, class Allocator>
+BasicSet<T, Compare, Allocator>::~BasicSet() {
+    make_empty();  // remove all actual nodes (and the index)
+    tail->~Node();  // the dummy nodes are stored in the Set, they are not deleted
+    head->~Node();
+}
+
+/*
+ * Assignment operator: assign new contents to *this Set, replacing its current content.
+ * Uses a variant of the copy-and-swap idiom: our parameter S is by value (and so is a copy).
+ * When an rvalue is assigned, S is move constructed and no node is copied.
+ * The dummy nodes cannot be swapped, since they are stored in the Sets, so
+ * the current nodes of *this are removed and then the list of S is moved into *this.
+ */
+template <class T, class Compare, class Allocator>
+auto BasicSet<T, Compare, Allocator>::operator=(BasicSet S) -> BasicSet& {
+    make_empty();
+    take_list(S);
+    return *this;
+}
+
+/*
+ * Test whether val belongs to the Set.
+ * The index, if any, was built by the operations that made the Set large enough.
+ */
+template <class T, class Compare, class Allocator>
+bool BasicSet<T, Compare, Allocator>::is_member(const T& val) const {
+    if (Index* idx = get_index()) {
+        Node* p = idx->find_predecessor(val);
+        return p->next != tail && !comp(val, p->next->value);
+    }
+
+    Node* current = head->next;
+    // Because the list is sorted, we can stop at the first value not smaller than val.
+    while (current != tail && comp(current->value, val)) {
+        current = current->next;
+    }
+    return current != tail && !comp(val, current->value);
+}
+
+/*
+ * Without an index, the list is walked from the start.
+ */
+template <class T, class Compare, class Allocator>
+size_t BasicSet<T, Compare, Allocator>::rank(const T& val) const {
+    if (Index* idx = get_index()) return idx->rank(val);
+
+    size_t n = 0;
+    for (Node* p = head->next; p != tail && comp(p->value, val); p = p->next) {
+        ++n;
+    }
+    return n;
+}
+
+template <class T, class Compare, class Allocator>
+const T& BasicSet<T, Compare, Allocator>::select(size_t k) const {
+    assert(k < counter);  // there is no k-th value otherwise
+
+    if (Index* idx = get_index()) return idx->select(k + 1)->value;
+
+    Node* p = head->next;
+    for (; k > 0; --k) {
+        p = p->next;
+    }
+    return p->value;
+}
+
+/*
+ * The first value not smaller than lo is found with the index, if any.
+ */
+template <class T, class Compare, class Allocator>
+std::vector<T> BasicSet<T, Compare, Allocator>::range(const T& lo, const T& hi) const {
+    std::vector<T> result;
+    Node* p = head;
+    if (Index* idx = get_index()) {
+        p = idx->find_predecessor(lo);
+    }
+    for (p = p->next; p != tail && comp(p->value, hi); p = p->next) {
+        if (!comp(p->value, lo)) result.push_back(p->value);
+    }
+    return result;
+}
+
+/*
+ * Merge the batch into the list, as operator+= merges two lists.
+ */
+template <class T, class Compare, class Allocator>
+size_t BasicSet<T, Compare, Allocator>::insert_range(std::span<const T> values) {
+    unshare();
+    std::vector<T> buffer;
+    values = sorted_unique(values, buffer);
+    if (values.size() == 1) return insert(values[0]) ? 1 : 0;
+    drop_index();
+
+    size_t inserted = 0;
+    Node* p = head->next;
+    for (const T& val : values) {
+        while (p != tail && comp(p->value, val)) {
+            p = p->next;
+        }
+        if (p == tail || comp(val, p->value)) {
+            insert_node(p->prev, val);
+            ++inserted;
+        }
+    }
+    counter += inserted;
+    finish_update();
+    return inserted;
+}
+
+/*
+ * Merge the batch with the list, as operator-= merges two lists.
+ */
+template <class T, class Compare, class Allocator>
+size_t BasicSet<T, Compare, Allocator>::erase_range(std::span<const T> values) {
+    unshare();
+    std::vector<T> buffer;
+    values = sorted_unique(values, buffer);
+    if (values.size() == 1) return erase(values[0]) ? 1 : 0;
+    drop_index();
+
+    size_t erased = 0;
+    Node* p = head->next;
+    for (const T& val : values) {
+        while (p != tail && comp(p->value, val)) {
+            p = p->next;
+        }
+        if (p == tail) break;
+        if (!comp(val, p->value)) {
+            Node* temp = p;
+            p = p->next;
+            remove_node(temp);
+            ++erased;
+        }
+    }
+    counter -= erased;
+    finish_update();
+    return erased;
+}
+
+/*
+ * Merge the queries with the list; the walk stops after the last query.
+ */
+template <class T, class Compare, class Allocator>
+std::vector<bool> BasicSet<T, Compare, Allocator>::are_members(std::span<const T> sorted_queries) const {
+    assert(std::is_sorted(sorted_queries.begin(), sorted_queries.end(), comp));  // else use Set::unsorted
+    std::vector<bool> result(sorted_queries.size());
+
+    Node* current = head->next;
+    for (size_t i = 0; i < sorted_queries.size(); ++i) {
+        while (current != tail && comp(current->value, sorted_queries[i])) {
+            current = current->next;
+        }
+        if (current == tail) break;
+        result[i] = !comp(sorted_queries[i], current->value);
+    }
+    return result;
+}
+
+/*
+ * The queries are sorted together with their positions, so that the results are
+ * written back in the original order of the queries.
+ */
+template <class T, class Compare, class Allocator>
+std::vector<bool> BasicSet<T, Compare, Allocator>::are_members(std::span<const T> queries, unsorted_t) const {
+    std::vector<std::pair<const T*, size_t>> order(queries.size());
+    for (size_t i = 0; i < queries.size(); ++i) {
+        order[i] = {&queries[i], i};
+    }
+    std::sort(order.begin(), order.end(), [this](const auto& a, const auto& b) { return comp(*a.first, *b.first); });
+
+    std::vector<bool> result(queries.size());
+
+    Node* current = head->next;
+    for (auto [val, i] : order) {
+        while (current != tail && comp(current->value, *val)) {
+            current = current->next;
+        }
+        if (current == tail) break;
+        result[i] = !comp(*val, current->value);
+    }
+    return result;
+}
+
+/*
+ * Insert val in the Set, if it is not there yet.
+ * The position is found with the index (which is then updated), or by a linear search.
+ */
+template <class T, class Compare, class Allocator>
+bool BasicSet<T, Compare, Allocator>::insert(const T& val) {
+    unshare();
+    build_index();  // if the list was just copied
+    Index* idx = get_index();
+    typename Index::Path path;
+
+    Node* p = head;
+    if (idx != nullptr) {
+        p = idx->find_predecessor(val, &path);
+    } else {
+        while (p->next != tail && comp(p->next->value, val))
+            p = p->next;
+    }
+
+    if (p->next != tail && !comp(val, p->next->value)) return false;  // already present
+
+    insert_node(p, val);
+    ++counter;
+    if (idx != nullptr) {
+        idx->add(p->next, path);
+    } else {
+        finish_update();  // the Set may have just become large enough
+    }
+    return true;
+}
+
+/*
+ * Remove val from the Set, if it is there.
+ * The position is found with the index (which is then updated), or by a linear search.
+ */
+template <class T, class Compare, class Allocator>
+bool BasicSet<T, Compare, Allocator>::erase(const T& val) {
+    unshare();
+    build_index();  // if the list was just copied
+    Index* idx = get_index();
+    typename Index::Path path;
+
+    Node* p = head;
+    if (idx != nullptr) {
+        p = idx->find_predecessor(val, &path);
+    } else {
+        while (p->next != tail && comp(p->next->value, val))
+            p = p->next;
+    }
+
+    Node* q = p->next;
+    if (q == tail || comp(val, q->value)) return false;  // not present
+
+    if (idx != nullptr) idx->remove(q, path);
+    remove_node(q);
+    --counter;
+    return true;
+}
+
+/*
+ * Three-way comparison operator.
+ * We iterate over both sets simultaneously. Since they are both sorted,
+ * a single pass through each list is enough to decide ordering.
+ * this_subset_S becomes false as soon as a value of *this is missing in S, and
+ * S_subset_this becomes false as soon as a value of S is missing in *this.
+ * A set with more elements cannot be a subset of the other, and the walk
+ * stops as soon as both directions have failed.
+ * Return:
+ *   - std::partial_ordering::equivalent if both sets contain the same elements,
+ *   - std::partial_ordering::less if *this is a proper subset of S,
+ *   - std::partial_ordering::greater if *this is a proper superset of S,
+ *   - std::partial_ordering::unordered otherwise.
+ */
+template <class T, class Compare, class Allocator>
+std::partial_ordering BasicSet<T, Compare, Allocator>::operator<=>(const BasicSet& S) const {
+    if (counter == S.counter && hash_sum != S.hash_sum) return std::partial_ordering::unordered;
+
+    bool this_subset_S = counter <= S.counter;
+    bool S_subset_this = S.counter <= counter;
+
+    Node* p1 = head->next;
+    Node* p2 = S.head->next;
+
+    while ((this_subset_S || S_subset_this) && p1 != tail && p2 != S.tail) {
+        if (comp(p1->value, p2->value)) {
+            this_subset_S = false;  // p1->value does not belong to S
+            p1 = p1->next;
+        }
+        else if (comp(p2->value, p1->value)) {
+            S_subset_this = false;  // p2->value does not belong to *this
+            p2 = p2->next;
+        }
+        else {
+            p1 = p1->next;
+            p2 = p2->next;
+        }
+    }
+    // Values left in one of the lists do not belong to the other set.
+    if (p1 != tail) this_subset_S = false;
+    if (p2 != S.tail) S_subset_this = false;
+
+    if (this_subset_S && S_subset_this)
+        return std::partial_ordering::equivalent;   // Both sets are identical.
+    else if (this_subset_S)
+        return std::partial_ordering::less;         // *this is a proper subset of S.
+    else if (S_subset_this)
+        return std::partial_ordering::greater;      // *this is a proper superset of S.
+    else
+        return std::partial_ordering::unordered;    // They are not comparable by inclusion.
+}
+
+/*
+ * Test whether Set *this and S represent the same set.
+ * Sets with different cardinality are rejected without visiting any node,
+ * otherwise both lists are compared value by value, stopping at the first difference.
+ */
+template <class T, class Compare, class Allocator>
+bool BasicSet<T, Compare, Allocator>::operator==(const BasicSet& S) const {
+    if (counter != S.counter || hash_sum != S.hash_sum) return false;
+
+    for (Node *p1 = head->next, *p2 = S.head->next; p1 != tail; p1 = p1->next, p2 = p2->next) {
+        if (!equivalent(p1->value, p2->value)) return false;
+    }
+    return true;
+}
+
+template <class T, class Compare, class Allocator>
+size_t BasicSet<T, Compare, Allocator>::hash() const {
+    return static_cast<size_t>(hash_sum);
+}
+
+/*
+ * Count the common elements with a merge walk, which stops as soon as one list
+ * is exhausted or the rest of one list is larger than the largest value of the other.
+ */
+template <class T, class Compare, class Allocator>
+size_t BasicSet<T, Compare, Allocator>::intersection_size(const BasicSet& S) const {
+    if (counter == 0 || S.counter == 0) return 0;
+
+    const T& last1 = tail->prev->value;
+    const T& last2 = S.tail->prev->value;
+    size_t n = 0;
+
+    Node* p1 = head->next;
+    Node* p2 = S.head->next;
+    while (p1 != tail && p2 != S.tail && !comp(last2, p1->value) && !comp(last1, p2->value)) {
+        if (comp(p1->value, p2->value)) {
+            p1 = p1->next;
+        } else if (comp(p2->value, p1->value)) {
+            p2 = p2->next;
+        } else {
+            ++n;
+            p1 = p1->next;
+            p2 = p2->next;
+        }
+    }
+    return n;
+}
+
+template <class T, class Compare, class Allocator>
+size_t BasicSet<T, Compare, Allocator>::union_size(const BasicSet& S) const {
+    return counter + S.counter - intersection_size(S);
+}
+
+template <class T, class Compare, class Allocator>
+size_t BasicSet<T, Compare, Allocator>::difference_size(const BasicSet& S) const {
+    return counter - intersection_size(S);
+}
+
+template <class T, class Compare, class Allocator>
+double BasicSet<T, Compare, Allocator>::jaccard(const BasicSet& S) const {
+    size_t common = intersection_size(S);
+    size_t all = counter + S.counter - common;
+    return (all == 0) ? 1.0 : static_cast<double>(common) / static_cast<double>(all);
+}
+
+/*
+ * Sets whose ranges of values do not overlap are disjoint, without any iteration.
+ */
+template <class T, class Compare, class Allocator>
+bool BasicSet<T, Compare, Allocator>::is_disjoint(const BasicSet& S) const {
+    if (counter == 0 || S.counter == 0) return true;
+    if (comp(tail->prev->value, S.head->next->value) || comp(S.tail->prev->value, head->next->value)) return true;
+
+    Node* p1 = head->next;
+    Node* p2 = S.head->next;
+    while (p1 != tail && p2 != S.tail) {
+        if (comp(p1->value, p2->value)) {
+            p1 = p1->next;
+        } else if (comp(p2->value, p1->value)) {
+            p2 = p2->next;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Modify Set *this such that it becomes the union of *this with S.
+ * We merge the two sorted lists, keeping each distinct element.
+ */
+template <class T, class Compare, class Allocator>
+auto BasicSet<T, Compare, Allocator>::operator+=(const BasicSet& S) -> BasicSet& {
+    unshare();
+    if (S.counter == 1) {
+        insert(S.head->next->value);
+        return *this;
+    }
+    drop_index();
+
+    Node* p1 = head->next;
+    Node* p2 = S.head->next;
+
+    // We iterate in a similar manner to merging sorted sequences.
+    while (p2 != S.tail) {
+        // Advance p1 until we find a node that is not less than p2->value.
+        while (p1 != tail && comp(p1->value, p2->value))
+            p1 = p1->next;
+
+        // If p1 points to a value greater than p2->value, then insert p2->value.
+        if (p1 == tail || comp(p2->value, p1->value)) {
+            // Insert new node right before p1 (i.e., after p1->prev)
+            insert_node(p1->prev, p2->value);
+            ++counter;
+        }
+        // Otherwise, the value is already present.
+        p2 = p2->next;
+    }
+    finish_update();
+    return *this;
+}
+
+/*
+ * Union with a Set S about to be destroyed.
+ * Same merge as above, but a value missing in *this is added by unlinking
+ * its node from S and linking it into *this, rather than by allocating a new node.
+ * Once the end of *this is reached, the rest of S is moved in one step.
+ */
+template <class T, class Compare, class Allocator>
+auto BasicSet<T, Compare, Allocator>::operator+=(BasicSet&& S) -> BasicSet& {
+    if (this == &S) return *this;
+    if ((S.shared != nullptr && S.shared->refs.load(std::memory_order_acquire) != 1) || !equal_allocators(S)) {
+        return *this += static_cast<const BasicSet&>(S);  // the nodes of S cannot become nodes of *this
+    }
+    unshare();
+    if (S.counter == 1) {
+        insert(S.head->next->value);
+        return *this;
+    }
+    drop_index();
+    S.drop_index();
+
+    Node* p1 = head->next;
+    Node* p2 = S.head->next;
+    size_t kept_in_S = 0;  // nodes of S passed by p2 and not moved (values already in *this)
+    std::uint64_t kept_hash = 0;  // sum of the hashes of those nodes
+
+    while (p2 != S.tail) {
+        // Advance p1 until we find a node that is not less than p2->value.
+        while (p1 != tail && comp(p1->value, p2->value))
+            p1 = p1->next;
+
+        if (p1 == tail) {
+            // The rest of S, [p2, S.tail->prev], goes after the last node of *this
+            Node* last2 = S.tail->prev;
+            size_t moved = S.counter - kept_in_S;
+            std::uint64_t moved_hash = S.hash_sum - kept_hash;
+
+            // Inline nodes of S in [p2, S.tail->prev] must be copied after the splice
+            Node* inline_moved[inline_capacity];
+            int n_inline_moved = 0;
+            for (int i = 0; i < inline_capacity; ++i) {
+                Node* q = reinterpret_cast<Node*>(S.inline_nodes[i].bytes);
+                if ((S.inline_used >> i & 1) && !comp(q->value, p2->value)) inline_moved[n_inline_moved++] = q;
+            }
+
+            p2->prev->next = S.tail;
+            S.tail->prev = p2->prev;
+
+            p2->prev = tail->prev;
+            tail->prev->next = p2;
+            last2->next = tail;
+            tail->prev = last2;
+
+            counter += moved;
+            S.counter -= moved;
+            hash_sum += moved_hash;
+            S.hash_sum -= moved_hash;
+
+            for (int i = 0; i < n_inline_moved; ++i) {
+                Node* q = inline_moved[i];
+                Node* new_node = allocate_node(q->value);
+                new_node->next = q->next;
+                new_node->prev = q->prev;
+                q->prev->next = new_node;
+                q->next->prev = new_node;
+                S.free_node(q);
+            }
+            break;
+        }
+
+        Node* next2 = p2->next;
+        if (comp(p2->value, p1->value) && S.is_inline(p2)) {
+            // p2 is stored in S, a copy is needed
+            insert_node(p1->prev, p2->value);
+            ++counter;
+            S.remove_node(p2);
+            --S.counter;
+        }
+        else if (comp(p2->value, p1->value)) {
+            // Unlink p2 from S
+            p2->prev->next = p2->next;
+            p2->next->prev = p2->prev;
+            --S.counter;
+            S.hash_sum -= hash_value(p2->value);
+
+            // Link p2 right before p1
+            p2->next = p1;
+            p2->prev = p1->prev;
+            p1->prev->next = p2;
+            p1->prev = p2;
+            ++counter;
+            hash_sum += hash_value(p2->value);
+        }
+        else {
+            ++kept_in_S;  // the value is already present
+            kept_hash += hash_value(p2->value);
+        }
+        p2 = next2;
+    }
+    finish_update();
+    S.finish_update();
+    return *this;
+}
+
+/*
+ * Modify Set *this such that it becomes the intersection of *this with S.
+ * We remove any nodes from *this that do not appear in S.
+ */
+template <class T, class Compare, class Allocator>
+auto BasicSet<T, Compare, Allocator>::operator*=(const BasicSet& S) -> BasicSet& {
+    unshare();
+    drop_index();
+
+    Node* p1 = head->next;
+    Node* p2 = S.head->next;
+
+    // Iterate while there are elements in *this and in S.
+    while (p1 != tail && p2 != S.tail) {
+        if (comp(p1->value, p2->value)) {
+            // p1->value is not in S, remove it.
+            Node* temp = p1;
+            p1 = p1->next;
+            remove_node(temp);
+            --counter;
+        }
+        else if (comp(p2->value, p1->value)) {
+            // Advance p2 to catch up.
+            p2 = p2->next;
+        }
+        else {
+            // p1->value is equivalent to p2->value, keep it in the intersection.
+            p1 = p1->next;
+            p2 = p2->next;
+        }
+    }
+    // Remove any remaining nodes in *this (they are not in S).
+    while (p1 != tail) {
+        Node* temp = p1;
+        p1 = p1->next;
+        remove_node(temp);
+        --counter;
+    }
+    finish_update();
+    return *this;
+}
+
+/*
+ * Modify Set *this such that it becomes the set difference between *this and S.
+ * That is, remove every node from *this that is present in S.
+ */
+template <class T, class Compare, class Allocator>
+auto BasicSet<T, Compare, Allocator>::operator-=(const BasicSet& S) -> BasicSet& {
+    // If S is the same object as *this, then removing all elements yields an empty set.
+    if (this == &S) {
+        make_empty();
+        return *this;
+    }
+    unshare();
+    if (S.counter == 1) {
+        erase(S.head->next->value);
+        return *this;
+    }
+    drop_index();
+
+    Node* p1 = head->next;
+    Node* p2 = S.head->next;
+
+    // Iterate over both lists.
+    while (p1 != tail && p2 != S.tail) {
+        if (comp(p1->value, p2->value)) {
+            // p1->value does not appear in S, so keep it.
+            p1 = p1->next;
+        }
+        else if (comp(p2->value, p1->value)) {
+            // p2->value is less; advance p2.
+            p2 = p2->next;
+        }
+        else {
+            // p1->value is found in S.
+            Node* temp = p1;  // Save pointer to the node to be removed.
+            p1 = p1->next;    // Advance p1 before removal.
+            remove_node(temp);
+            --counter;
+            p2 = p2->next;
+        }
+    }
+    finish_update();
+    return *this;
+}
+
+/*****************************************************
+ * Private Member Functions -- Implementation         *
+ ******************************************************/
+
+ /*
+  * Insert a new Node storing val after the Node pointed by p.
+  */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::insert_node(Node* p, const T& val) {
+    // Create new node, inline or with the Allocator
+    Node* new_node = allocate_node(val);
+
+    // Adjust pointers to insert new_node after p
+    new_node->next = p->next;
+    new_node->prev = p;
+    p->next->prev = new_node;
+    p->next = new_node;
+    hash_sum += hash_value(val);
+    // Node count is maintained externally.
+}
+
+/*
+ * Remove the Node pointed by p.
+ */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::remove_node(Node* p) {
+    // Adjust the pointers to bypass p
+    p->prev->next = p->next;
+    p->next->prev = p->prev;
+    hash_sum -= hash_value(p->value);
+    free_node(p);
+    // Node count is maintained externally.
+}
+
+/*
+ * The first free inline node is used, if any, unless the list is in a Shared body
+ * (which may outlive the Set).
+ */
+template <class T, class Compare, class Allocator>
+auto BasicSet<T, Compare, Allocator>::allocate_node(const T& val) -> Node* {
+    if (shared == nullptr && inline_used != (1u << inline_capacity) - 1) {
+        int i = std::countr_one(inline_used);
+        Node* p = new (inline_nodes[i].bytes) Node{ val };
+        inline_used |= std::uint8_t(1u << i);
+        return p;
+    }
+    return allocate_external_node(val);
+}
+
+/*
+ * The memory of the Node comes from the NodePool (default allocator)
+ * or from the Allocator, and it is released if the value cannot be copied.
+ */
+template <class T, class Compare, class Allocator>
+auto BasicSet<T, Compare, Allocator>::allocate_external_node(const T& val) -> Node* {
+    if constexpr (uses_node_pool) {
+        void* where = Node::pool().allocate();
+        try {
+            return new (where) Node{ val };
+        } catch (...) {
+            Node::pool().deallocate(where);
+            throw;
+        }
+    } else {
+        NodeAllocator node_alloc{ alloc };
+        Node* where = std::allocator_traits<NodeAllocator>::allocate(node_alloc, 1);
+        try {
+            return new (where) Node{ val };
+        } catch (...) {
+            std::allocator_traits<NodeAllocator>::deallocate(node_alloc, where, 1);
+            throw;
+        }
+    }
+}
+
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::free_node(Node* p) {
+    if (is_inline(p)) {
+        auto i = reinterpret_cast<NodeStorage*>(p) - inline_nodes;
+        p->~Node();
+        inline_used &= std::uint8_t(~(1u << i));
+    }
+    else if constexpr (uses_node_pool) {
+        p->~Node();
+        Node::pool().deallocate(p);
+    }
+    else {
+        NodeAllocator node_alloc{ alloc };
+        p->~Node();
+        std::allocator_traits<NodeAllocator>::deallocate(node_alloc, p, 1);
+    }
+}
+
+template <class T, class Compare, class Allocator>
+bool BasicSet<T, Compare, Allocator>::is_inline(const Node* p) const {
+    // std::less gives a total order also for pointers to unrelated objects
+    const void* q = p;
+    return !std::less<const void*>{}(q, inline_nodes) && std::less<const void*>{}(q, inline_nodes + inline_capacity);
+}
+
+/*
+ * If the allocators differ, the nodes of S cannot be freed by *this: the values are copied.
+ * If S reads a Shared body, *this reads it instead of S.
+ * Otherwise, the list of S is linked between the dummy nodes of *this and then every inline node of S
+ * is replaced by a copy in the same inline node of *this (all inline nodes of *this are free).
+ * The index of S, if any, is kept and updated.
+ */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::take_list(BasicSet& S) {
+    if (!equal_allocators(S)) {
+        Node* p = head;
+        for (Node* q = S.head->next; q != S.tail; q = q->next) {
+            insert_node(p, q->value);
+            p = p->next;
+            ++counter;
+        }
+        S.make_empty();
+        finish_update();
+        return;
+    }
+    if (S.shared != nullptr) {
+        shared = S.shared;
+        head = S.head;
+        tail = S.tail;
+        counter = S.counter;
+        hash_sum = S.hash_sum;
+        S.detach();
+        return;
+    }
+    if (S.counter == 0) return;
+
+    head->next = S.head->next;
+    head->next->prev = head;
+    tail->prev = S.tail->prev;
+    tail->prev->next = tail;
+    S.head->next = S.tail;
+    S.tail->prev = S.head;
+
+    counter = S.counter;
+    S.counter = 0;
+    hash_sum = S.hash_sum;
+    S.hash_sum = 0;
+    index = S.index;
+    S.index = nullptr;
+    if (index != nullptr) index->set_head(head);
+
+    for (int i = 0; i < inline_capacity; ++i) {
+        if ((S.inline_used >> i & 1) == 0) continue;
+
+        Node* old_node = reinterpret_cast<Node*>(S.inline_nodes[i].bytes);
+        Node* new_node = new (inline_nodes[i].bytes) Node{ old_node->value, old_node->next, old_node->prev };
+        old_node->prev->next = new_node;
+        old_node->next->prev = new_node;
+        if (index != nullptr) index->relocate(old_node, new_node);
+        old_node->~Node();
+    }
+    inline_used = S.inline_used;
+    S.inline_used = 0;
+}
+
+/*
+ * The dummy nodes of the body are constructed and linked to each other.
+ */
+template <class T, class Compare, class Allocator>
+auto BasicSet<T, Compare, Allocator>::new_body() -> Shared* {
+    Shared* body = new Shared{};
+    Node* body_head = new (body->dummy_nodes[0].bytes) Node{};
+    Node* body_tail = new (body->dummy_nodes[1].bytes) Node{};
+    body_head->next = body_tail;
+    body_tail->prev = body_head;
+    return body;
+}
+
+/*
+ * The Nodes of the list are freed with the allocator of *this, equal to the one that allocated them.
+ */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::delete_body(Shared* body) {
+    Node* body_head = reinterpret_cast<Node*>(body->dummy_nodes[0].bytes);
+    Node* body_tail = reinterpret_cast<Node*>(body->dummy_nodes[1].bytes);
+    for (Node* p = body_head->next; p != body_tail;) {
+        Node* next = p->next;
+        free_node(p);
+        p = next;
+    }
+    delete body->index;
+    body_tail->~Node();
+    body_head->~Node();
+    delete body;
+}
+
+/*
+ * The list, and its index if any, are relinked between the dummy nodes of a new Shared body,
+ * and the inline nodes are replaced by Nodes allocated with the Allocator.
+ * The replacements are allocated first, so that the Set is unchanged if an exception is thrown.
+ */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::share() {
+    if (shared != nullptr || counter <= inline_capacity) return;
+
+    Shared* body = new_body();
+    Node* replacements[inline_capacity];
+    int n = 0;
+    try {
+        for (int i = 0; i < inline_capacity; ++i) {
+            if (inline_used >> i & 1) {
+                replacements[n] = allocate_external_node(reinterpret_cast<Node*>(inline_nodes[i].bytes)->value);
+                ++n;
+            }
+        }
+    } catch (...) {
+        while (n > 0) free_node(replacements[--n]);
+        delete_body(body);
+        throw;
+    }
+
+    Node* body_head = reinterpret_cast<Node*>(body->dummy_nodes[0].bytes);
+    Node* body_tail = reinterpret_cast<Node*>(body->dummy_nodes[1].bytes);
+    body_head->next = head->next;
+    body_head->next->prev = body_head;
+    body_tail->prev = tail->prev;
+    body_tail->prev->next = body_tail;
+    head->next = tail;  // our own dummy nodes are not used while the list is shared
+    tail->prev = head;
+    body->index = index;
+    index = nullptr;
+    if (body->index != nullptr) body->index->set_head(body_head);
+
+    n = 0;
+    for (int i = 0; i < inline_capacity; ++i) {
+        if ((inline_used >> i & 1) == 0) continue;
+
+        Node* old_node = reinterpret_cast<Node*>(inline_nodes[i].bytes);
+        Node* new_node = replacements[n++];
+        new_node->next = old_node->next;
+        new_node->prev = old_node->prev;
+        old_node->prev->next = new_node;
+        old_node->next->prev = new_node;
+        if (body->index != nullptr) body->index->relocate(old_node, new_node);
+        old_node->~Node();
+    }
+    inline_used = 0;
+
+    shared = body;
+    head = body_head;
+    tail = body_tail;
+}
+
+/*
+ * If other Sets read the body, the values are copied to a new body, without an index:
+ * the operation about to modify the list builds it again (see finish_update).
+ */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::unshare() {
+    if (shared == nullptr || shared->refs.load(std::memory_order_acquire) == 1) return;
+
+    Shared* body = new_body();
+    Node* body_head = reinterpret_cast<Node*>(body->dummy_nodes[0].bytes);
+    Node* body_tail = reinterpret_cast<Node*>(body->dummy_nodes[1].bytes);
+    try {
+        for (Node* q = head->next; q != tail; q = q->next) {
+            Node* p = allocate_external_node(q->value);
+            p->next = body_tail;
+            p->prev = body_tail->prev;
+            body_tail->prev->next = p;
+            body_tail->prev = p;
+        }
+    } catch (...) {
+        delete_body(body);
+        throw;
+    }
+
+    Shared* old_body = shared;
+    shared = body;
+    head = body_head;
+    tail = body_tail;
+    if (old_body->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete_body(old_body);  // the others were destroyed meanwhile
+}
+
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::release() {
+    Shared* body = shared;
+    detach();
+    if (body->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete_body(body);
+}
+
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::detach() {
+    shared = nullptr;
+    head = reinterpret_cast<Node*>(dummy_nodes[0].bytes);
+    tail = reinterpret_cast<Node*>(dummy_nodes[1].bytes);
+    head->next = tail;
+    tail->prev = head;
+    counter = 0;
+    hash_sum = 0;
+}
+
+/*
+ * A Set reading a Shared body uses the index of the body.
+ */
+template <class T, class Compare, class Allocator>
+auto BasicSet<T, Compare, Allocator>::get_index() const -> Index* {
+    return shared != nullptr ? shared->index : index;
+}
+
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::build_index() {
+    Index*& idx = shared != nullptr ? shared->index : index;
+    if (idx == nullptr && counter >= index_threshold) {
+        idx = new Index{head, tail, comp};
+    }
+}
+
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::drop_index() {
+    Index*& idx = shared != nullptr ? shared->index : index;
+    delete idx;
+    idx = nullptr;
+}
+
+/*
+ * The list is shared first, so that the index is built over the list of the body.
+ */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::finish_update() {
+    share();
+    build_index();
+}
+
+/*
+ * Write Set *this to stream os.
+ */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::write_to_stream(std::ostream& os) const {
+    if (counter == 0) {
+        os << "Set is empty!";
+    }
+    else {
+        Node* ptr = head->next;
+        os << "{ ";
+        while (ptr != tail) {
+            os << ptr->value << " ";
+            ptr = ptr->next;
+        }
+        os << "}";
+    }
+}
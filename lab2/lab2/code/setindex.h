@@ -0,0 +1,327 @@
+#pragma once
+
+#include <cstdint>
+
+#include "set.h"
+#include "node.h"
+#include "nodepool.h"
+
+/** Class BasicSet::Index
+ *
+ * Skip-list index over the sorted list of Nodes of a Set.
+ * Level 0 has one entry for about every 4th Node of the list, level 1 one entry
+ * for about every 4th entry of level 0, and so on. Each entry stores the value of
+ * the Node it refers to, a pointer to the next entry in the same level, and
+ * a pointer to the entry below (in level 0, the entry below is the Node itself).
+ *
+ * Searching descends the levels from the top, so that is_member, insert, and erase
+ * visit O(log n) entries and Nodes, in the expected case.
+ * Each entry also stores its width, the number of Nodes from its Node to the Node of the
+ * next entry in the same level (or to the dummy tail), so that the position of a Node in
+ * the list is found during the same descent: rank and select also take O(log n) expected time.
+ * The index only refers to Nodes, it does not own them.
+ * Its entries are allocated from a NodePool (per type of Set), whatever the Allocator of the Set.
+ */
+template <class T, class Compare, class Allocator>
+class BasicSet<T, Compare, Allocator>::Index {
+public:
+    class Entry;
+
+    static constexpr int max_levels = 16;  // enough for 4^16 values
+    static constexpr int fanout_bits = 2;  // an entry is promoted to the next level with probability 1/4
+
+    /*
+     * Constructor: build a perfectly balanced index over the list between head and tail,
+     * sorted by comp.
+     */
+    Index(Node* head, Node* tail, const Compare& comp);
+
+    /*
+     * Destructor: release all entries (not the Nodes of the list).
+     */
+    ~Index();
+
+    Index(const Index&) = delete;
+    Index& operator=(const Index&) = delete;
+
+    /*
+     * Search path of find_predecessor, in each level: the last entry whose value is smaller than val,
+     * and the position of its Node in the list (the dummy head is at position 0).
+     */
+    struct Path {
+        Entry* preds[max_levels];
+        std::size_t positions[max_levels];
+        std::size_t position;  // position of the Node returned by find_predecessor
+    };
+
+    /*
+     * Return the last Node of the list whose value is smaller than val (possibly the dummy head).
+     * If path is not nullptr, the search path is stored in *path.
+     */
+    Node* find_predecessor(const T& val, Path* path = nullptr) const;
+
+    /*
+     * Return the number of Nodes of the list whose values are smaller than val.
+     */
+    std::size_t rank(const T& val) const;
+
+    /*
+     * Return the Node at position k of the list, 1 <= k <= number of Nodes.
+     */
+    Node* select(std::size_t k) const;
+
+    /*
+     * Add entries for Node p, just inserted in the list, with a random number of levels.
+     * path must have been computed by find_predecessor(p->value, &path), before p was inserted.
+     */
+    void add(Node* p, const Path& path);
+
+    /*
+     * Remove the entries of Node p, which is about to be removed from the list.
+     * path must have been computed by find_predecessor(p->value, &path).
+     */
+    void remove(Node* p, const Path& path);
+
+    /*
+     * The dummy head Node of the list is now stored at new_head.
+     */
+    void set_head(Node* new_head);
+
+    /*
+     * Node old_node of the list has been replaced by new_node (with the same value):
+     * update the entries referring to old_node.
+     */
+    void relocate(const Node* old_node, Node* new_node);
+
+    /*
+     * Entry of a level of the index.
+     */
+    class Entry {
+    public:
+        T value;            // value of node
+        Node* node;         // Node of the list that this entry refers to
+        Entry* next;        // next entry in the same level, nullptr if last
+        Entry* down;        // entry for the same Node in the level below, nullptr in level 0
+        std::size_t width;  // number of Nodes from node to the Node of next (or to the dummy tail)
+
+        static void* operator new(std::size_t size) {
+            if (size != sizeof(Entry)) return ::operator new(size);
+            return pool().allocate();
+        }
+
+        static void operator delete(void* p, std::size_t size) noexcept {
+            if (size != sizeof(Entry)) {
+                ::operator delete(p);
+                return;
+            }
+            pool().deallocate(p);
+        }
+
+        // Never destroyed, as the pool of the Nodes: a static Set may delete its index after it
+        static NodePool& pool() {
+            static NodePool& the_pool = *new NodePool{sizeof(Entry), alignof(Entry)};
+            return the_pool;
+        }
+    };
+
+private:
+    Entry* heads[max_levels];  // first (dummy) entry of each level, referring to the dummy head Node
+    int levels;                // number of levels in use
+    std::uint32_t seed;        // state of the random number generator used by add
+    [[no_unique_address]] Compare comp;  // order of the values, as in the Set
+
+    int random_levels();
+};
+
+/*****************************************************
+ * Implementation of the member functions             *
+ ******************************************************/
+
+/*
+ * Every 4th Node of the list gets an entry in level 0,
+ * every 16th Node gets an entry in level 1, and so on.
+ */
+template <class T, class Compare, class Allocator>
+BasicSet<T, Compare, Allocator>::Index::Index(Node* head, Node* tail, const Compare& comp)
+    : levels{1}, seed{0x9E3779B9u}, comp{comp} {
+    Entry* last[max_levels];
+    std::size_t last_position[max_levels];
+    for (int l = 0; l < max_levels; ++l) {
+        heads[l] = new Entry{head->value, head, nullptr, (l == 0) ? nullptr : heads[l - 1], 0};
+        last[l] = heads[l];
+        last_position[l] = 0;
+    }
+
+    std::size_t position = 0;
+    for (Node* p = head->next; p != tail; p = p->next) {
+        ++position;
+        Entry* below = nullptr;
+        for (int l = 0; l < max_levels && position % (std::size_t{1} << (fanout_bits * (l + 1))) == 0; ++l) {
+            last[l]->width = position - last_position[l];
+            below = last[l]->next = new Entry{p->value, p, nullptr, below, 0};
+            last[l] = below;
+            last_position[l] = position;
+            if (l + 1 > levels) levels = l + 1;
+        }
+    }
+
+    // The last entry of each level reaches the dummy tail, at position n + 1
+    for (int l = 0; l < max_levels; ++l) {
+        last[l]->width = position + 1 - last_position[l];
+    }
+}
+
+template <class T, class Compare, class Allocator>
+BasicSet<T, Compare, Allocator>::Index::~Index() {
+    for (int l = 0; l < max_levels; ++l) {
+        Entry* e = heads[l];
+        while (e != nullptr) {
+            Entry* temp = e;
+            e = e->next;
+            delete temp;
+        }
+    }
+}
+
+/*
+ * Descend from the top level: in each level, move right while the next entry is smaller than val.
+ * Then walk the list from the Node of the level 0 entry.
+ * The position is the sum of the widths of the entries moved over.
+ */
+template <class T, class Compare, class Allocator>
+auto BasicSet<T, Compare, Allocator>::Index::find_predecessor(const T& val, Path* path) const -> Node* {
+    Entry* e = heads[levels - 1];
+    std::size_t position = 0;
+    for (int l = levels - 1; l >= 0; --l) {
+        while (e->next != nullptr && comp(e->next->value, val)) {
+            position += e->width;
+            e = e->next;
+        }
+        if (path != nullptr) {
+            path->preds[l] = e;
+            path->positions[l] = position;
+        }
+        if (l > 0) e = e->down;
+    }
+    if (path != nullptr) {
+        for (int l = levels; l < max_levels; ++l) {
+            path->preds[l] = heads[l];
+            path->positions[l] = 0;
+        }
+    }
+
+    Node* p = e->node;
+    while (p->next->next != nullptr && comp(p->next->value, val)) {  // p->next->next == nullptr for the dummy tail
+        p = p->next;
+        ++position;
+    }
+    if (path != nullptr) path->position = position;
+    return p;
+}
+
+template <class T, class Compare, class Allocator>
+std::size_t BasicSet<T, Compare, Allocator>::Index::rank(const T& val) const {
+    Path path;
+    find_predecessor(val, &path);
+    return path.position;
+}
+
+/*
+ * Descend from the top level: in each level, move right while the next entry is not after position k.
+ */
+template <class T, class Compare, class Allocator>
+auto BasicSet<T, Compare, Allocator>::Index::select(std::size_t k) const -> Node* {
+    Entry* e = heads[levels - 1];
+    std::size_t position = 0;
+    for (int l = levels - 1; l >= 0; --l) {
+        while (e->next != nullptr && position + e->width <= k) {
+            position += e->width;
+            e = e->next;
+        }
+        if (l > 0) e = e->down;
+    }
+
+    Node* p = e->node;
+    for (; position < k; ++position) {
+        p = p->next;
+    }
+    return p;
+}
+
+/*
+ * The new Node is at position r = path.position + 1: the entries before it, in the levels
+ * where it gets an entry, now reach it; in the other levels, they span one more Node.
+ */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::Index::add(Node* p, const Path& path) {
+    int n = random_levels();
+    std::size_t r = path.position + 1;
+    Entry* below = nullptr;
+    for (int l = 0; l < max_levels; ++l) {
+        Entry* pred = path.preds[l];
+        if (l < n) {
+            std::size_t to_pred = r - path.positions[l];
+            below = pred->next = new Entry{p->value, p, pred->next, below, pred->width + 1 - to_pred};
+            pred->width = to_pred;
+        } else {
+            ++pred->width;
+        }
+    }
+    if (n > levels) levels = n;
+}
+
+/*
+ * The entries before p absorb the widths of the entries of p, and span one Node less.
+ */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::Index::remove(Node* p, const Path& path) {
+    for (int l = 0; l < max_levels; ++l) {
+        Entry* pred = path.preds[l];
+        Entry* e = pred->next;
+        if (e != nullptr && e->node == p) {
+            pred->width += e->width;
+            pred->next = e->next;
+            delete e;
+        }
+        --pred->width;
+    }
+}
+
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::Index::set_head(Node* new_head) {
+    for (int l = 0; l < max_levels; ++l) {
+        heads[l]->node = new_head;
+    }
+}
+
+/*
+ * The entries of old_node are found by searching its value.
+ */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::Index::relocate(const Node* old_node, Node* new_node) {
+    Entry* e = heads[levels - 1];
+    for (int l = levels - 1; l >= 0; --l) {
+        while (e->next != nullptr && comp(e->next->value, new_node->value)) {
+            e = e->next;
+        }
+        if (e->next != nullptr && e->next->node == old_node) e->next->node = new_node;
+        if (l > 0) e = e->down;
+    }
+}
+
+/*
+ * Number of levels for a new entry: 0 with probability 3/4, 1 with probability 3/16, ...
+ * (xorshift32 random number generator)
+ */
+template <class T, class Compare, class Allocator>
+int BasicSet<T, Compare, Allocator>::Index::random_levels() {
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+
+    int n = 0;
+    for (std::uint32_t bits = seed; n < max_levels && (bits & ((1u << fanout_bits) - 1)) == 0; bits >>= fanout_bits) {
+        ++n;
+    }
+    return n;
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <iterator>
+
+#include "set.h"
+#include "node.h"
+
+/** Class BasicSet::const_iterator
+ *
+ * Bidirectional iterator over the Nodes of the list of a Set: it stores a pointer to a Node,
+ * increment follows next and decrement follows prev.
+ * The end iterator refers to the dummy tail Node, so that --end() is the largest value.
+ * BasicSet::const_iterator satisfies std::bidirectional_iterator, and BasicSet models
+ * std::ranges::bidirectional_range: Sets can be used with the std::ranges algorithms and views.
+ */
+template <class T, class Compare, class Allocator>
+class BasicSet<T, Compare, Allocator>::const_iterator {
+public:
+    using iterator_concept = std::bidirectional_iterator_tag;
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    const_iterator() = default;
+
+    reference operator*() const {
+        return p->value;
+    }
+
+    pointer operator->() const {
+        return &p->value;
+    }
+
+    const_iterator& operator++() {
+        p = p->next;
+        return *this;
+    }
+
+    const_iterator operator++(int) {
+        const_iterator old{*this};
+        p = p->next;
+        return old;
+    }
+
+    const_iterator& operator--() {
+        p = p->prev;
+        return *this;
+    }
+
+    const_iterator operator--(int) {
+        const_iterator old{*this};
+        p = p->prev;
+        return old;
+    }
+
+    bool operator==(const const_iterator&) const = default;
+
+private:
+    friend class BasicSet;
+
+    explicit const_iterator(const Node* p) : p{p} {
+    }
+
+    const Node* p = nullptr;
+};
+
+template <class T, class Compare, class Allocator>
+inline auto BasicSet<T, Compare, Allocator>::begin() const -> const_iterator {
+    return const_iterator{head->next};
+}
+
+template <class T, class Compare, class Allocator>
+inline auto BasicSet<T, Compare, Allocator>::end() const -> const_iterator {
+    return const_iterator{tail};
+}
@@ -0,0 +1,195 @@
+#pragma once
+
+#include <algorithm>
+#include <iterator>
+#include <vector>
+
+#include "set.h"
+#include "threadpool.h"
+
+/*
+ * Union and intersection of many Sets on a ThreadPool.
+ * Set::union_all and Set::intersect_all are compiled in set.cpp: this file is only needed
+ * to call them on other BasicSets, so that set.h does not depend on threadpool.h.
+ *
+ * Sets are not thread-safe: the workers only read the lists (and their indexes),
+ * and write their results to vectors. The result Set is built by the caller.
+ */
+
+/*****************************************************
+ * K-way merge                                        *
+ ******************************************************/
+
+/*
+ * Loser tree over the lists of k Sets: internal node i (1 <= i < k) holds the leaf that lost the
+ * match played there, and losers[0] the overall winner (the list with the smallest current value).
+ * Leaf j is below internal node (j + k) / 2. After the winner advances, only the matches
+ * on its path to the root are replayed: log2(k) comparisons per value.
+ */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::merge_all(std::span<const BasicSet* const> group, std::vector<T>& out) {
+    const size_t k = group.size();
+    const Compare& comp = group[0]->comp;
+    std::vector<const Node*> current(k);
+    std::vector<const T*> keys(k);  // value of current[j], or nullptr once list j is exhausted
+    for (size_t j = 0; j < k; ++j) {
+        current[j] = group[j]->head->next;
+        keys[j] = current[j] != group[j]->tail ? &current[j]->value : nullptr;
+    }
+
+    // An exhausted list loses against any other
+    auto beats = [&](size_t a, size_t b) {
+        if (keys[a] == nullptr) return false;
+        if (keys[b] == nullptr) return true;
+        return comp(*keys[a], *keys[b]);
+    };
+
+    std::vector<size_t> losers(k);
+    auto play = [&](auto& self, size_t node) -> size_t {  // return the winner below node
+        if (node >= k) return node - k;
+        size_t left = self(self, 2 * node);
+        size_t right = self(self, 2 * node + 1);
+        bool left_wins = !beats(right, left);
+        losers[node] = left_wins ? right : left;
+        return left_wins ? left : right;
+    };
+    losers[0] = play(play, 1);  // for k == 1, node 1 is leaf 0
+
+    while (keys[losers[0]] != nullptr) {
+        size_t winner = losers[0];
+        const T& val = *keys[winner];
+        if (out.empty() || comp(out.back(), val)) out.push_back(val);
+        current[winner] = current[winner]->next;
+        keys[winner] = current[winner] != group[winner]->tail ? &current[winner]->value : nullptr;
+
+        for (size_t node = (winner + k) / 2; node >= 1; node /= 2) {
+            if (beats(losers[node], winner)) std::swap(losers[node], winner);
+        }
+        losers[0] = winner;
+    }
+}
+
+/*
+ * Each worker merges a group of consecutive Sets with a loser tree.
+ * The merged groups are then merged pairwise, in rounds run in parallel:
+ * log2(number of groups) rounds.
+ */
+template <class T, class Compare, class Allocator>
+BasicSet<T, Compare, Allocator> BasicSet<T, Compare, Allocator>::union_all(std::span<const BasicSet* const> sets,
+                                                                         ThreadPool& pool) {
+    if (sets.empty()) return BasicSet{};
+    const Compare& comp = sets[0]->comp;
+
+    const size_t groups = std::min<size_t>(sets.size(), pool.size());
+    std::vector<std::vector<T>> merged(groups);
+    pool.parallel_for(groups, [&](size_t g) {
+        size_t first = sets.size() * g / groups;
+        size_t last = sets.size() * (g + 1) / groups;
+        merge_all(sets.subspan(first, last - first), merged[g]);
+    });
+
+    while (merged.size() > 1) {
+        std::vector<std::vector<T>> next((merged.size() + 1) / 2);
+        pool.parallel_for(next.size(), [&](size_t i) {
+            if (2 * i + 1 == merged.size()) {
+                next[i] = std::move(merged[2 * i]);
+                return;
+            }
+            const std::vector<T>& a = merged[2 * i];
+            const std::vector<T>& b = merged[2 * i + 1];
+            next[i].reserve(std::max(a.size(), b.size()));
+            std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(next[i]), comp);
+        });
+        merged = std::move(next);
+    }
+
+    BasicSet result{comp, sets[0]->alloc};
+    result.insert_range(merged[0]);
+    return result;
+}
+
+/*****************************************************
+ * Intersection                                       *
+ ******************************************************/
+
+/*
+ * Walk the list from the first candidate, but jump with the index when the next
+ * candidate is more than max_walk Nodes ahead: O(min(gap, log n)) time per candidate.
+ */
+template <class T, class Compare, class Allocator>
+void BasicSet<T, Compare, Allocator>::keep_members(std::span<const T> candidates, const Index* idx,
+                                                   std::vector<T>& out) const {
+    constexpr int max_walk = 16;
+    if (candidates.empty()) return;
+
+    const Node* p = idx != nullptr ? idx->find_predecessor(candidates[0])->next : head->next;
+    for (const T& val : candidates) {
+        int steps = 0;
+        while (p != tail && comp(p->value, val)) {
+            if (++steps > max_walk && idx != nullptr) {
+                p = idx->find_predecessor(val)->next;
+                break;
+            }
+            p = p->next;
+        }
+        if (p == tail) return;
+        if (!comp(val, p->value)) out.push_back(val);
+    }
+}
+
+/*
+ * Start from the values of the smallest Set, and keep those that belong to the next Sets,
+ * by increasing cardinality, so that the candidates shrink as fast as possible.
+ * Each round splits the candidates into chunks, filtered in parallel, with the index of the Set
+ * (large Sets are always indexed, see is_member).
+ */
+template <class T, class Compare, class Allocator>
+BasicSet<T, Compare, Allocator> BasicSet<T, Compare, Allocator>::intersect_all(std::span<const BasicSet* const> sets,
+                                                                             ThreadPool& pool) {
+    if (sets.empty()) return BasicSet{};
+    const Compare& comp = sets[0]->comp;
+    BasicSet result{comp, sets[0]->alloc};
+
+    std::vector<const BasicSet*> order(sets.begin(), sets.end());
+    std::sort(order.begin(), order.end(),
+              [](const BasicSet* a, const BasicSet* b) { return a->counter < b->counter; });
+    if (order[0]->is_empty()) return result;
+
+    std::vector<T> candidates;
+    candidates.reserve(order[0]->counter);
+    for (const Node* p = order[0]->head->next; p != order[0]->tail; p = p->next) {
+        candidates.push_back(p->value);
+    }
+
+    const size_t chunks_per_worker = 4;  // so that a worker with a slow chunk is not waited for too long
+    for (size_t s = 1; s < order.size() && !candidates.empty(); ++s) {
+        const BasicSet& S = *order[s];
+        const Index* idx = S.get_index();
+
+        const size_t chunks = std::min(candidates.size(), chunks_per_worker * pool.size());
+        std::vector<std::vector<T>> kept(chunks);
+        pool.parallel_for(chunks, [&](size_t c) {
+            size_t first = candidates.size() * c / chunks;
+            size_t last = candidates.size() * (c + 1) / chunks;
+            S.keep_members(std::span<const T>{candidates}.subspan(first, last - first), idx, kept[c]);
+        });
+
+        candidates.clear();
+        for (const auto& part : kept) {
+            candidates.insert(candidates.end(), part.begin(), part.end());
+        }
+    }
+
+    result.insert_range(candidates);
+    return result;
+}
+
+template <class T, class Compare, class Allocator>
+BasicSet<T, Compare, Allocator> BasicSet<T, Compare, Allocator>::union_all(std::span<const BasicSet* const> sets) {
+    return union_all(sets, ThreadPool::shared());
+}
+
+template <class T, class Compare, class Allocator>
+BasicSet<T, Compare, Allocator> BasicSet<T, Compare, Allocator>::intersect_all(std::span<const BasicSet* const> sets) {
+    return intersect_all(sets, ThreadPool::shared());
+}
@@ -0,0 +1,51 @@
+#include "setpool.h"
+#include <cassert>
+#include <functional>
+#include <utility>
+
+/*****************************************************
+ * Implementation of the member functions             *
+ ******************************************************/
+
+SetPool::Handle SetPool::intern(Set&& S) {
+    if (auto it = lookup.find(&S); it != lookup.end()) {
+        return it->second;
+    }
+    Handle canonical{std::make_shared<const Set>(std::move(S))};
+    lookup.emplace(canonical.S.get(), canonical);
+    return canonical;
+}
+
+SetPool::Handle SetPool::unite(Handle A, Handle B) {
+    assert(A && B);
+    Key k = std::less<const Set*>{}(A.S.get(), B.S.get()) ? Key{A.S.get(), B.S.get()} : Key{B.S.get(), A.S.get()};
+    return memoized(unions, k, [](const Set& S1, const Set& S2) -> Set { return S1 + S2; });
+}
+
+SetPool::Handle SetPool::intersect(Handle A, Handle B) {
+    assert(A && B);
+    Key k = std::less<const Set*>{}(A.S.get(), B.S.get()) ? Key{A.S.get(), B.S.get()} : Key{B.S.get(), A.S.get()};
+    return memoized(intersections, k, [](const Set& S1, const Set& S2) -> Set { return S1 * S2; });
+}
+
+SetPool::Handle SetPool::subtract(Handle A, Handle B) {
+    assert(A && B);
+    return memoized(differences, Key{A.S.get(), B.S.get()}, [](const Set& S1, const Set& S2) -> Set { return S1 - S2; });
+}
+
+/*****************************************************
+ * Private Member Functions -- Implementation         *
+ ******************************************************/
+
+template <class Op>
+SetPool::Handle SetPool::memoized(Memo& memo, Key k, Op op) {
+    if (auto it = memo.find(k); it != memo.end()) {
+        return it->second;
+    }
+    if (memo.size() >= memo_limit) {
+        memo.clear();  // the results stay interned, only the operations are forgotten
+    }
+    Handle result = intern(op(*k.A, *k.B));
+    memo.emplace(k, result);
+    return result;
+}
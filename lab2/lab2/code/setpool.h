@@ -0,0 +1,174 @@
+#pragma once
+
+#include <memory>
+#include <utility>
+#include <unordered_map>
+#include <cstddef>
+
+#include "set.h"
+
+/** Class to intern (hash-cons) Sets.
+ *
+ *  SetPool keeps a single canonical instance of each distinct Set given to intern,
+ *  and hands out Handles to it: a Handle is one shared pointer, however large the Set is,
+ *  so the memory used scales with the number of distinct Sets, not with the number of Handles.
+ *  Two Handles of the same pool are equal if and only if they refer to equal Sets,
+ *  which is tested by comparing the pointers.
+ *
+ *  The union, intersection and difference of Handles are memoized, so each distinct operation
+ *  is computed once, until its table holds memo_limit results and is cleared.
+ *  The canonical Sets are immutable; each lives as long as the SetPool or its last Handle.
+ */
+class SetPool {
+public:
+    /*
+     * Shared, immutable reference to a canonical Set of a SetPool.
+     * The Set is shared by the Handle, so it may outlive its SetPool.
+     */
+    class Handle {
+    public:
+        /*
+         * Handle to no Set: it must not be dereferenced or given to a SetPool.
+         */
+        Handle() = default;
+
+        const Set& operator*() const {
+            return *S;
+        }
+
+        const Set* operator->() const {
+            return S.get();
+        }
+
+        /*
+         * Return true if the Handle refers to a Set.
+         */
+        explicit operator bool() const {
+            return S != nullptr;
+        }
+
+        /*
+         * Handles of the same SetPool refer to equal Sets only if they are the same pointer.
+         */
+        bool operator==(const Handle&) const = default;
+
+        /*
+         * Return a hash of the Handle, consistent with operator==.
+         */
+        size_t hash() const {
+            return std::hash<const Set*>{}(S.get());
+        }
+
+    private:
+        friend class SetPool;
+
+        explicit Handle(std::shared_ptr<const Set> S) : S{std::move(S)} {
+        }
+
+        std::shared_ptr<const Set> S;
+    };
+
+    /*
+     * Create an empty SetPool, whose memo tables are cleared when they reach memo_limit results.
+     */
+    explicit SetPool(size_t memo_limit = 1 << 16) : memo_limit{memo_limit} {
+    }
+
+    SetPool(const SetPool&) = delete;
+    SetPool& operator=(const SetPool&) = delete;
+
+    /*
+     * Return the Handle of the canonical Set equal to S.
+     * If there is none yet, S is moved into the pool and becomes the canonical Set.
+     * Expected O(1) time if S is new, or if it is not equal to another Set with the same hash,
+     * otherwise O(n) time to compare it with the canonical Set.
+     */
+    Handle intern(Set&& S);
+
+    /*
+     * Return the Handle of the union of *A and *B, memoized.
+     * A and B must not be null Handles (same for intersect and subtract).
+     */
+    Handle unite(Handle A, Handle B);
+
+    /*
+     * Return the Handle of the intersection of *A and *B, memoized.
+     */
+    Handle intersect(Handle A, Handle B);
+
+    /*
+     * Return the Handle of the set difference *A - *B, memoized.
+     */
+    Handle subtract(Handle A, Handle B);
+
+    /*
+     * Return the number of distinct Sets in the pool.
+     */
+    size_t size() const {
+        return lookup.size();
+    }
+
+    /*
+     * Return the number of results memoized by unite, intersect and subtract.
+     */
+    size_t memo_size() const {
+        return unions.size() + intersections.size() + differences.size();
+    }
+
+private:
+    struct SetHash {
+        size_t operator()(const Set* S) const {
+            return S->hash();
+        }
+    };
+
+    struct SetEqual {
+        bool operator()(const Set* S1, const Set* S2) const {
+            return *S1 == *S2;
+        }
+    };
+
+    // Operands of a memoized operation
+    struct Key {
+        const Set* A;
+        const Set* B;
+        bool operator==(const Key&) const = default;
+    };
+
+    struct KeyHash {
+        size_t operator()(const Key& k) const {
+            return std::hash<const Set*>{}(k.A) * 31 + std::hash<const Set*>{}(k.B);
+        }
+    };
+
+    using Memo = std::unordered_map<Key, Handle, KeyHash>;
+
+    // The canonical Sets, each keyed by its own address (so a Set can be looked up by value)
+    std::unordered_map<const Set*, Handle, SetHash, SetEqual> lookup;
+    size_t memo_limit;    // Maximum number of results in each memo table
+
+    Memo unions;          // A + B, with A <= B as pointers since + is commutative
+    Memo intersections;   // A * B, with A <= B as pointers since * is commutative
+    Memo differences;     // A - B
+
+    /* **************************
+     * Private Member Functions *
+     * ************************** */
+
+    /*
+     * Return the memoized result of op for key k in table memo,
+     * computing and interning it on the first call. A full table is cleared first.
+     */
+    template <class Op>
+    Handle memoized(Memo& memo, Key k, Op op);
+};
+
+/*
+ * Handles can be used as keys of the unordered standard containers.
+ */
+template <>
+struct std::hash<SetPool::Handle> {
+    size_t operator()(const SetPool::Handle& H) const noexcept {
+        return H.hash();
+    }
+};
@@ -0,0 +1,57 @@
+#include "threadpool.h"
+#include <algorithm>
+
+/*****************************************************
+ * Implementation of the member functions             *
+ ******************************************************/
+
+ThreadPool::ThreadPool(unsigned threads) {
+    threads = std::max(threads, 1u);
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back([this] { run_worker(); });
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard lock{m};
+        stopping = true;
+    }
+    ready.notify_all();
+    for (auto& w : workers) {
+        w.join();
+    }
+}
+
+ThreadPool& ThreadPool::shared() {
+    static ThreadPool the_pool;
+    return the_pool;
+}
+
+/*
+ * Take tasks from the queue until the pool is stopping and the queue is empty.
+ */
+void ThreadPool::run_worker() {
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock lock{m};
+            ready.wait(lock, [this] { return stopping || !tasks.empty(); });
+            if (tasks.empty()) return;
+            task = std::move(tasks.front());
+            tasks.pop_front();
+        }
+        task();
+    }
+}
+
+void ThreadPool::enqueue(std::vector<std::function<void()>>& batch) {
+    {
+        std::lock_guard lock{m};
+        for (auto& task : batch) {
+            tasks.push_back(std::move(task));
+        }
+    }
+    ready.notify_all();
+}
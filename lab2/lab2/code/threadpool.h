@@ -0,0 +1,96 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/** Class to run tasks on a fixed set of worker threads.
+ *
+ *  The workers are created by the constructor and wait for tasks until the ThreadPool is destroyed.
+ *  parallel_for runs n tasks and returns when all of them are done, so that the caller can then
+ *  use their results without any further synchronization.
+ *  Tasks must not call parallel_for on the same ThreadPool (a worker would wait for itself).
+ */
+class ThreadPool {
+public:
+    /*
+     * Constructor: create a pool of threads workers (at least one).
+     */
+    explicit ThreadPool(unsigned threads = std::thread::hardware_concurrency());
+
+    /*
+     * Destructor: let the workers finish the queued tasks, then join them.
+     */
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    /*
+     * Return the number of worker threads.
+     */
+    unsigned size() const {
+        return static_cast<unsigned>(workers.size());
+    }
+
+    /*
+     * Run f(0), f(1), ..., f(n - 1) on the workers, and wait until all calls have returned.
+     * If some calls throw, the first exception is rethrown here.
+     */
+    template <class F>
+    void parallel_for(std::size_t n, F f);
+
+    /*
+     * Pool with one worker per hardware thread, created on first use.
+     */
+    static ThreadPool& shared();
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex m;                   // protects tasks and stopping
+    std::condition_variable ready;  // a task was queued, or the pool is stopping
+    bool stopping = false;
+
+    void run_worker();
+    void enqueue(std::vector<std::function<void()>>& batch);
+};
+
+/*
+ * The calls count down a shared counter; the caller waits until it reaches 0.
+ */
+template <class F>
+void ThreadPool::parallel_for(std::size_t n, F f) {
+    if (n == 0) return;
+
+    std::mutex done_mutex;
+    std::condition_variable done;
+    std::size_t remaining = n;
+    std::exception_ptr error;
+
+    std::vector<std::function<void()>> batch;
+    batch.reserve(n);
+    for (std::size_t i = 0; i < n; ++i) {
+        batch.emplace_back([&, i] {
+            std::exception_ptr e;
+            try {
+                f(i);
+            } catch (...) {
+                e = std::current_exception();
+            }
+            std::lock_guard lock{done_mutex};
+            if (e && !error) error = e;
+            if (--remaining == 0) done.notify_one();
+        });
+    }
+    enqueue(batch);
+
+    std::unique_lock lock{done_mutex};
+    done.wait(lock, [&] { return remaining == 0; });
+    if (error) std::rethrow_exception(error);
+}
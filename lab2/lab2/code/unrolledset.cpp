@@ -0,0 +1,411 @@
+#include "unrolledset.h"
+#include <algorithm>
+#include <utility>
+
+/*****************************************************
+ * Blocks, cursors over the values of a list          *
+ ******************************************************/
+
+namespace {
+
+// Never destroyed, as the pool of the Set Nodes: a static UnrolledSet may free its Blocks after it
+NodePool& block_pool(std::size_t size, std::size_t alignment) {
+    static NodePool& the_pool = *new NodePool{size, alignment};
+    return the_pool;
+}
+
+}  // namespace
+
+void* UnrolledSet::Block::operator new(std::size_t) {
+    return block_pool(sizeof(Block), alignof(Block)).allocate();
+}
+
+void UnrolledSet::Block::operator delete(void* p, std::size_t) noexcept {
+    block_pool(sizeof(Block), alignof(Block)).deallocate(p);
+}
+
+/*
+ * Reads the values of a list increasingly.
+ */
+class UnrolledSet::Cursor {
+public:
+    explicit Cursor(const Block* b) : b{b}, i{0} {
+    }
+    bool done() const {
+        return b == nullptr;
+    }
+    int value() const {
+        return b->values[i];
+    }
+    void advance() {
+        if (++i == b->count) {
+            b = b->next;
+            i = 0;
+        }
+    }
+
+private:
+    const Block* b;
+    int i;
+};
+
+/*
+ * Overwrites the values of a list from its first Block on, filling each Block completely.
+ * Used to compact a list in place: the Writer never passes a Cursor reading the same list,
+ * since the Blocks before the Cursor had at most block_capacity values.
+ */
+class UnrolledSet::Writer {
+public:
+    explicit Writer(Block* b) : b{b}, i{0} {
+    }
+    void write(int val) {
+        b->values[i++] = val;
+        if (i == block_capacity) {
+            b->count = block_capacity;
+            b = b->next;
+            i = 0;
+        }
+    }
+    Block* block() const {
+        return b;
+    }
+    int position() const {
+        return i;
+    }
+
+private:
+    Block* b;
+    int i;
+};
+
+/*****************************************************
+ * Implementation of the member functions             *
+ ******************************************************/
+
+UnrolledSet::UnrolledSet(int val) {
+    append(val);
+}
+
+UnrolledSet::UnrolledSet(const std::vector<int>& list_of_values) {
+    for (int val : list_of_values) {
+        append(val);
+    }
+}
+
+/*
+ * The copy is packed into full Blocks.
+ */
+UnrolledSet::UnrolledSet(const UnrolledSet& S) {
+    for (const Block* b = S.first; b != nullptr; b = b->next) {
+        for (int i = 0; i < b->count; ++i) {
+            append(b->values[i]);
+        }
+    }
+}
+
+UnrolledSet::UnrolledSet(UnrolledSet&& S) noexcept
+    : first{std::exchange(S.first, nullptr)},
+      last{std::exchange(S.last, nullptr)},
+      counter{std::exchange(S.counter, 0)} {
+}
+
+void UnrolledSet::make_empty() {
+    while (first != nullptr) {
+        Block* temp = first;
+        first = first->next;
+        delete temp;
+    }
+    last = nullptr;
+    counter = 0;
+}
+
+UnrolledSet::~UnrolledSet() {
+    make_empty();
+}
+
+UnrolledSet& UnrolledSet::operator=(UnrolledSet S) {
+    std::swap(first, S.first);
+    std::swap(last, S.last);
+    std::swap(counter, S.counter);
+    return *this;
+}
+
+bool UnrolledSet::is_member(int val) const {
+    const Block* b = find_block(val);
+    return b != nullptr && std::binary_search(b->values, b->values + b->count, val);
+}
+
+bool UnrolledSet::insert(int val) {
+    Block* b = find_block(val);
+    if (b == nullptr) {
+        append(val);
+        return true;
+    }
+    int* pos = std::lower_bound(b->values, b->values + b->count, val);
+    if (pos != b->values + b->count && *pos == val) return false;
+
+    insert_node(b, static_cast<int>(pos - b->values), val);
+    ++counter;
+    return true;
+}
+
+bool UnrolledSet::erase(int val) {
+    Block* b = find_block(val);
+    if (b == nullptr) return false;
+
+    int* pos = std::lower_bound(b->values, b->values + b->count, val);
+    if (pos == b->values + b->count || *pos != val) return false;
+
+    remove_node(b, static_cast<int>(pos - b->values));
+    --counter;
+    return true;
+}
+
+size_t UnrolledSet::memory_usage() const {
+    size_t blocks = 0;
+    for (const Block* b = first; b != nullptr; b = b->next) {
+        ++blocks;
+    }
+    return sizeof(UnrolledSet) + blocks * sizeof(Block);
+}
+
+/*
+ * Single simultaneous pass through both lists, as Set::operator<=>.
+ */
+std::partial_ordering UnrolledSet::operator<=>(const UnrolledSet& S) const {
+    bool this_subset_S = counter <= S.counter;
+    bool S_subset_this = S.counter <= counter;
+
+    Cursor c1{first};
+    Cursor c2{S.first};
+    while ((this_subset_S || S_subset_this) && !c1.done() && !c2.done()) {
+        if (c1.value() < c2.value()) {
+            this_subset_S = false;
+            c1.advance();
+        } else if (c2.value() < c1.value()) {
+            S_subset_this = false;
+            c2.advance();
+        } else {
+            c1.advance();
+            c2.advance();
+        }
+    }
+    if (!c1.done()) this_subset_S = false;
+    if (!c2.done()) S_subset_this = false;
+
+    if (this_subset_S && S_subset_this)
+        return std::partial_ordering::equivalent;
+    else if (this_subset_S)
+        return std::partial_ordering::less;
+    else if (S_subset_this)
+        return std::partial_ordering::greater;
+    else
+        return std::partial_ordering::unordered;
+}
+
+bool UnrolledSet::operator==(const UnrolledSet& S) const {
+    if (counter != S.counter) return false;
+
+    for (Cursor c1{first}, c2{S.first}; !c1.done(); c1.advance(), c2.advance()) {
+        if (c1.value() != c2.value()) return false;
+    }
+    return true;
+}
+
+/*
+ * The union is merged into a new list of full Blocks, which then replaces the list of *this.
+ */
+UnrolledSet& UnrolledSet::operator+=(const UnrolledSet& S) {
+    if (this == &S || S.counter == 0) return *this;
+
+    UnrolledSet result;
+    Cursor c1{first};
+    Cursor c2{S.first};
+    while (!c1.done() || !c2.done()) {
+        if (c2.done() || (!c1.done() && c1.value() < c2.value())) {
+            result.append(c1.value());
+            c1.advance();
+        } else if (c1.done() || c2.value() < c1.value()) {
+            result.append(c2.value());
+            c2.advance();
+        } else {
+            result.append(c1.value());
+            c1.advance();
+            c2.advance();
+        }
+    }
+    *this = std::move(result);
+    return *this;
+}
+
+/*
+ * The intersection is compacted in place, into full Blocks; the Blocks left over are deallocated.
+ */
+UnrolledSet& UnrolledSet::operator*=(const UnrolledSet& S) {
+    if (this == &S || first == nullptr) return *this;
+
+    Writer out{first};
+    size_t n = 0;
+    Cursor c1{first};
+    Cursor c2{S.first};
+    while (!c1.done() && !c2.done()) {
+        if (c1.value() < c2.value()) {
+            c1.advance();
+        } else if (c2.value() < c1.value()) {
+            c2.advance();
+        } else {
+            int val = c1.value();
+            c1.advance();  // before writing, as val may be overwritten
+            c2.advance();
+            out.write(val);
+            ++n;
+        }
+    }
+
+    // Keep the Blocks before the Writer position, and the current one if it was written
+    Block* keep_last = (out.position() > 0) ? out.block() : (out.block() ? out.block()->prev : last);
+    if (out.position() > 0) keep_last->count = out.position();
+    while (last != keep_last) {
+        unlink(last);
+    }
+    counter = n;
+    return *this;
+}
+
+/*
+ * The difference is compacted in place, into full Blocks; the Blocks left over are deallocated.
+ */
+UnrolledSet& UnrolledSet::operator-=(const UnrolledSet& S) {
+    if (this == &S) {
+        make_empty();
+        return *this;
+    }
+    if (first == nullptr || S.first == nullptr) return *this;
+
+    Writer out{first};
+    size_t n = 0;
+    Cursor c1{first};
+    Cursor c2{S.first};
+    while (!c1.done()) {
+        if (c2.done() || c1.value() < c2.value()) {
+            int val = c1.value();
+            c1.advance();
+            out.write(val);
+            ++n;
+        } else if (c2.value() < c1.value()) {
+            c2.advance();
+        } else {
+            c1.advance();
+            c2.advance();
+        }
+    }
+
+    Block* keep_last = (out.position() > 0) ? out.block() : (out.block() ? out.block()->prev : last);
+    if (out.position() > 0) keep_last->count = out.position();
+    while (last != keep_last) {
+        unlink(last);
+    }
+    counter = n;
+    return *this;
+}
+
+/*****************************************************
+ * Private Member Functions -- Implementation         *
+ ******************************************************/
+
+/*
+ * A full Block is split into two half-full Blocks first.
+ */
+void UnrolledSet::insert_node(Block* b, int pos, int val) {
+    if (b->count == block_capacity) {
+        Block* upper = new Block;
+        int half = block_capacity / 2;
+        upper->count = block_capacity - half;
+        std::copy(b->values + half, b->values + block_capacity, upper->values);
+        b->count = half;
+
+        upper->prev = b;
+        upper->next = b->next;
+        if (b->next != nullptr)
+            b->next->prev = upper;
+        else
+            last = upper;
+        b->next = upper;
+
+        if (pos > half) {
+            b = upper;
+            pos -= half;
+        }
+    }
+    std::copy_backward(b->values + pos, b->values + b->count, b->values + b->count + 1);
+    b->values[pos] = val;
+    ++b->count;
+}
+
+/*
+ * An empty Block is deallocated; a Block less than half full absorbs the next Block,
+ * if their values fit in one Block.
+ */
+void UnrolledSet::remove_node(Block* b, int pos) {
+    std::copy(b->values + pos + 1, b->values + b->count, b->values + pos);
+    --b->count;
+
+    if (b->count == 0) {
+        unlink(b);
+        return;
+    }
+    Block* next = b->next;
+    if (b->count < block_capacity / 2 && next != nullptr && b->count + next->count <= block_capacity) {
+        std::copy(next->values, next->values + next->count, b->values + b->count);
+        b->count += next->count;
+        unlink(next);
+    }
+}
+
+void UnrolledSet::append(int val) {
+    if (last == nullptr || last->count == block_capacity) {
+        Block* b = new Block;
+        b->prev = last;
+        if (last != nullptr)
+            last->next = b;
+        else
+            first = b;
+        last = b;
+    }
+    last->values[last->count++] = val;
+    ++counter;
+}
+
+void UnrolledSet::unlink(Block* b) {
+    if (b->prev != nullptr)
+        b->prev->next = b->next;
+    else
+        first = b->next;
+    if (b->next != nullptr)
+        b->next->prev = b->prev;
+    else
+        last = b->prev;
+    delete b;
+}
+
+UnrolledSet::Block* UnrolledSet::find_block(int val) const {
+    Block* b = first;
+    while (b != nullptr && b->next != nullptr && b->values[b->count - 1] < val) {
+        b = b->next;
+    }
+    return b;
+}
+
+void UnrolledSet::write_to_stream(std::ostream& os) const {
+    if (counter == 0) {
+        os << "Set is empty!";
+    } else {
+        os << "{ ";
+        for (const Block* b = first; b != nullptr; b = b->next) {
+            for (int i = 0; i < b->count; ++i) {
+                os << b->values[i] << " ";
+            }
+        }
+        os << "}";
+    }
+}
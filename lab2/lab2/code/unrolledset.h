@@ -0,0 +1,218 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <compare>  // C++20 three-way comparison operator
+
+#include "nodepool.h"
+
+/** Class to represent a Set of ints, as an unrolled linked list.
+ *
+ *  UnrolledSet has the same public interface as Set, but each node of its
+ *  doubly linked list (a Block) stores up to block_capacity increasingly sorted ints,
+ *  and a Block fills exactly one 64-byte cache line.
+ *  A full Block is split in two when a value is inserted in it, and a Block that
+ *  becomes less than half full is merged with the next Block when they fit in one.
+ *
+ *  The merge operators write their result into completely filled Blocks,
+ *  so a Set built by them uses about 5.8 bytes per value (instead of a 24-byte Set::Node).
+ *  All UnrolledSet operations have a linear time complexity, in the worst case.
+ */
+class UnrolledSet {
+public:
+    /*
+     * Default constructor: create an empty UnrolledSet.
+     */
+    UnrolledSet() = default;
+
+    /*
+     * Conversion constructor: convert val into a singleton {val}.
+     */
+    UnrolledSet(int val);
+
+    /*
+     * Constructor to create an UnrolledSet from a sorted vector of unique ints.
+     * \param list_of_values is an increasingly sorted vector of unique ints.
+     */
+    explicit UnrolledSet(const std::vector<int>& list_of_values);
+
+    /*
+     * Copy constructor: create a new UnrolledSet as a copy of S.
+     */
+    UnrolledSet(const UnrolledSet& S);
+
+    /*
+     * Move constructor: take over the Blocks of S, which becomes empty.
+     */
+    UnrolledSet(UnrolledSet&& S) noexcept;
+
+    /*
+     * Transform the UnrolledSet into an empty set.
+     */
+    void make_empty();
+
+    /*
+     * Destructor: deallocate all Blocks.
+     */
+    ~UnrolledSet();
+
+    /*
+     * Assignment operator, using the copy-and-swap idiom.
+     */
+    UnrolledSet& operator=(UnrolledSet S);
+
+    /*
+     * Test whether val belongs to the UnrolledSet.
+     * Only the largest value of each Block is compared, until the Block that may contain val.
+     */
+    bool is_member(int val) const;
+
+    /*
+     * Insert val, if it does not belong to the UnrolledSet yet.
+     * Return true if val was inserted, otherwise false.
+     */
+    bool insert(int val);
+
+    /*
+     * Remove val, if it belongs to the UnrolledSet.
+     * Return true if val was removed, otherwise false.
+     */
+    bool erase(int val);
+
+    /*
+     * Test whether the UnrolledSet is empty.
+     */
+    bool is_empty() const {
+        return (counter == 0);
+    }
+
+    /*
+     * Count the number of values stored in the UnrolledSet.
+     */
+    size_t cardinality() const {
+        return counter;
+    }
+
+    /*
+     * Return the number of bytes used by the UnrolledSet.
+     */
+    size_t memory_usage() const;
+
+    /*
+     * Three-way comparison operator, with the same semantics as Set::operator<=>.
+     */
+    std::partial_ordering operator<=>(const UnrolledSet& S) const;
+
+    /*
+     * Test whether UnrolledSet *this and S represent the same set.
+     */
+    bool operator==(const UnrolledSet& S) const;
+
+    /*
+     * Modify UnrolledSet *this such that it becomes the union of *this with S.
+     */
+    UnrolledSet& operator+=(const UnrolledSet& S);
+
+    /*
+     * Modify UnrolledSet *this such that it becomes the intersection of *this with S.
+     */
+    UnrolledSet& operator*=(const UnrolledSet& S);
+
+    /*
+     * Modify UnrolledSet *this such that it becomes the set difference between *this and S.
+     */
+    UnrolledSet& operator-=(const UnrolledSet& S);
+
+    /* *******************************************
+     * Overloaded operators: non-member functions *
+     * ******************************************* */
+
+    /*
+     * Overloaded operator<<, writes S with the same format as a Set.
+     */
+    friend std::ostream& operator<<(std::ostream& os, const UnrolledSet& S) {
+        S.write_to_stream(os);
+        return os;
+    }
+
+    /*
+     * Overloaded operator+: union S1 + S2.
+     */
+    friend UnrolledSet operator+(UnrolledSet S1, const UnrolledSet& S2) {
+        return (S1 += S2);
+    }
+
+    /*
+     * Overloaded operator*: intersection S1 * S2.
+     */
+    friend UnrolledSet operator*(UnrolledSet S1, const UnrolledSet& S2) {
+        return (S1 *= S2);
+    }
+
+    /*
+     * Overloaded operator-: difference S1 - S2.
+     */
+    friend UnrolledSet operator-(UnrolledSet S1, const UnrolledSet& S2) {
+        return (S1 -= S2);
+    }
+
+private:
+    static constexpr size_t block_bytes = 64;  // size of a cache line
+    static constexpr int block_capacity = static_cast<int>((block_bytes - 2 * sizeof(void*) - sizeof(int)) / sizeof(int));
+
+    /*
+     * Node of the list: a cache line with up to block_capacity values.
+     */
+    struct alignas(block_bytes) Block {
+        Block* next = nullptr;
+        Block* prev = nullptr;
+        int count = 0;  // number of values in the Block, never 0 for a Block in the list
+        int values[block_capacity];
+
+        static void* operator new(std::size_t size);
+        static void operator delete(void* p, std::size_t size) noexcept;
+    };
+
+    class Cursor;
+    class Writer;
+
+    Block* first = nullptr;  // First Block of the list, or nullptr if the set is empty
+    Block* last = nullptr;   // Last Block of the list, or nullptr if the set is empty
+    size_t counter = 0;      // Number of values in the UnrolledSet.
+
+    /* **************************
+     * Private Member Functions *
+     * ************************** */
+
+    /*
+     * Insert val at position pos of Block b, splitting b if it is full.
+     */
+    void insert_node(Block* b, int pos, int val);
+
+    /*
+     * Remove the value at position pos of Block b, merging b with the next Block
+     * if both fit in one Block.
+     */
+    void remove_node(Block* b, int pos);
+
+    /*
+     * Append val, larger than all values in the list, filling the last Block first.
+     */
+    void append(int val);
+
+    /*
+     * Unlink and deallocate Block b.
+     */
+    void unlink(Block* b);
+
+    /*
+     * Return the Block where val is or should be inserted (the first Block whose
+     * largest value is not smaller than val, or the last Block), nullptr if the set is empty.
+     */
+    Block* find_block(int val) const;
+
+    /*
+     * Write UnrolledSet *this to stream os.
+     */
+    void write_to_stream(std::ostream& os) const;
+};